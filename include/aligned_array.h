@@ -0,0 +1,91 @@
+#ifndef OTREZKI_ALIGNED_ARRAY_H
+#define OTREZKI_ALIGNED_ARRAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <new>
+
+// Массив фиксированного (после resize) размера, начало которого выровнено на Align байт -
+// загрузка целых строк кэша и выровненные векторные чтения. Выделяется с запасом, адрес исходного
+// блока хранится прямо перед выровненным началом; работает без aligned new из C++17
+template <typename T, size_t Align = 64>
+class AlignedArray {
+    T* items = nullptr;
+    size_t count = 0;
+    size_t capacity = 0;
+
+    static T* allocate(size_t n) {
+        if (n == 0) return nullptr;
+        char* raw = static_cast<char*>(::operator new(n * sizeof(T) + Align + sizeof(void*)));
+        uintptr_t start = reinterpret_cast<uintptr_t>(raw + sizeof(void*));
+        start = (start + Align - 1) & ~uintptr_t(Align - 1);
+        reinterpret_cast<void**>(start)[-1] = raw;
+        return reinterpret_cast<T*>(start);
+    }
+
+    static void release(T* p) {
+        if (p) {
+            ::operator delete(reinterpret_cast<void**>(p)[-1]);
+        }
+    }
+
+public:
+    AlignedArray() = default;
+
+    explicit AlignedArray(size_t n) : items(allocate(n)), count(n), capacity(n) {}
+
+    AlignedArray(const AlignedArray& other) : items(allocate(other.count)), count(other.count), capacity(other.count) {
+        std::copy(other.items, other.items + count, items);
+    }
+
+    AlignedArray(AlignedArray&& other) noexcept : items(other.items), count(other.count), capacity(other.capacity) {
+        other.items = nullptr;
+        other.count = 0;
+        other.capacity = 0;
+    }
+
+    AlignedArray& operator=(AlignedArray other) {
+        std::swap(items, other.items);
+        std::swap(count, other.count);
+        std::swap(capacity, other.capacity);
+        return *this;
+    }
+
+    ~AlignedArray() {
+        release(items);
+    }
+
+    // Новый размер; прежнее содержимое не сохраняется (массив заполняется заново).
+    // Уменьшение и рост в пределах уже выделенного блока память не перераспределяют
+    void resize(size_t n) {
+        if (n > capacity) {
+            release(items);
+            items = allocate(n);
+            capacity = n;
+        }
+        count = n;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    T* data() {
+        return items;
+    }
+
+    const T* data() const {
+        return items;
+    }
+
+    T& operator[](size_t i) {
+        return items[i];
+    }
+
+    const T& operator[](size_t i) const {
+        return items[i];
+    }
+};
+
+#endif // OTREZKI_ALIGNED_ARRAY_H
@@ -6,8 +6,13 @@
 #include <algorithm>
 #include <queue>
 #include <stack>
+#include <vector>
+#include <functional>
+#include <stdexcept>
 
-template <typename TKey, typename TValue>
+// TCompare - строгий порядок на ключах (по умолчанию operator<);
+// позволяет хранить ключи, порядок которых задаётся внешним состоянием (например, положением заметающей прямой)
+template <typename TKey, typename TValue, typename TCompare = std::less<TKey>>
 class AVLTree {
 private:
 
@@ -39,6 +44,27 @@ private:
     };
     Node* root = nullptr;
     int treeSize = 0;
+    TCompare cmp;
+
+    // Удалённые узлы не освобождаются, а складываются в список свободных (связь через left)
+    // и достаются при следующих вставках: дерево, которое опустошается и заполняется снова
+    // (статус заметающей прямой), после разогрева не обращается к куче
+    Node* freeNodes = nullptr;
+
+    Node* createNode(const TKey& key, const TValue& value) {
+        if (!freeNodes) {
+            return new Node(key, value);
+        }
+        Node* node = freeNodes;
+        freeNodes = node->left;
+        *node = Node(key, value);
+        return node;
+    }
+
+    void releaseNode(Node* node) {
+        node->left = freeNodes;
+        freeNodes = node;
+    }
 
     int getHeight(Node* node) const {
         return node ? node->height : 0;
@@ -104,12 +130,12 @@ private:
     Node* insert(Node* node, const TKey& key, const TValue& value) {
         if (!node) {
             treeSize++;
-            return new Node(key, value);
+            return createNode(key, value);
         }
 
-        if (key < node->data.key) {
+        if (cmp(key, node->data.key)) {
             node->left = insert(node->left, key, value);
-        } else if (key > node->data.key) {
+        } else if (cmp(node->data.key, key)) {
             node->right = insert(node->right, key, value);
         } /*else {
             throw std::runtime_error("ID already exists");
@@ -125,12 +151,23 @@ private:
         return node;
     }
 
+    Node* eraseMin(Node* node) {
+        if (!node->left) {
+            Node* right = node->right;
+            releaseNode(node);
+            treeSize--;
+            return right;
+        }
+        node->left = eraseMin(node->left);
+        return balance(node);
+    }
+
     Node* erase(Node* node, const TKey& key) {
         if (!node) return nullptr;
 
-        if (key < node->data.key) {
+        if (cmp(key, node->data.key)) {
             node->left = erase(node->left, key);
-        } else if (key > node->data.key) {
+        } else if (cmp(node->data.key, key)) {
             node->right = erase(node->right, key);
         } else {
             if (!node->left || !node->right) {
@@ -141,12 +178,13 @@ private:
                 } else {
                     *node = *temp;
                 }
-                delete temp;
+                releaseNode(temp);
                 treeSize--;
             } else {
+                // Минимум правого поддерева удаляем структурно, без повторного поиска по ключу
                 Node* temp = findMin(node->right);
                 node->data = temp->data;
-                node->right = erase(node->right, temp->data.key);
+                node->right = eraseMin(node->right);
             }
         }
 
@@ -180,6 +218,19 @@ private:
         return newNode;
     }
 
+    void findAll(Node* node, const TKey& key, std::vector<TValue>& values) const {
+        if (!node) return;
+        if (cmp(key, node->data.key)) {
+            findAll(node->left, key, values);
+        } else if (cmp(node->data.key, key)) {
+            findAll(node->right, key, values);
+        } else {
+            findAll(node->left, key, values);
+            values.push_back(node->data.value);
+            findAll(node->right, key, values);
+        }
+    }
+
     void clearTree(Node* node) {
         if (node) {
             clearTree(node->left);
@@ -188,6 +239,14 @@ private:
         }
     }
 
+    void releaseTree(Node* node) {
+        if (node) {
+            releaseTree(node->left);
+            releaseTree(node->right);
+            releaseNode(node);
+        }
+    }
+
 public:
 
     // Поиск предшественника (наибольший элемент, меньший key)
@@ -196,7 +255,7 @@ public:
         Node* pred = nullptr;
 
         while (current != nullptr) {
-            if (current->data.key < key) {
+            if (cmp(current->data.key, key)) {
                 pred = current;
                 current = current->right;
             }
@@ -219,7 +278,7 @@ public:
         Node* succ = nullptr;
 
         while (current != nullptr) {
-            if (current->data.key > key) {
+            if (cmp(key, current->data.key)) {
                 succ = current;
                 current = current->left;
             }
@@ -236,19 +295,41 @@ public:
         return false;
     }
 
+    // Все значения, ключи которых эквивалентны key (ни один не меньше другого), в порядке возрастания ключей
+    // Имеет смысл для "пробных" ключей, равных целому диапазону ключей дерева; работает за O(log n + m)
+    void findAll(const TKey& key, std::vector<TValue>& values) const {
+        findAll(root, key, values);
+    }
+
     AVLTree() : root(nullptr), treeSize(0) {}
-    AVLTree(const AVLTree& other) : root(copyTree(other.root)), treeSize(other.treeSize) {}
-    ~AVLTree() { clearTree(root); }
+    explicit AVLTree(const TCompare& compare) : root(nullptr), treeSize(0), cmp(compare) {}
+    AVLTree(const AVLTree& other) : root(copyTree(other.root)), treeSize(other.treeSize), cmp(other.cmp) {}
+    ~AVLTree() {
+        clearTree(root);
+        while (freeNodes) {
+            Node* next = freeNodes->left;
+            delete freeNodes;
+            freeNodes = next;
+        }
+    }
 
     AVLTree& operator=(const AVLTree& other) {
         if (this != &other) {
             clearTree(root);
             root = copyTree(other.root);
             treeSize = other.treeSize;
+            cmp = other.cmp;
         }
         return *this;
     }
 
+    // Опустошение дерева за O(n); узлы остаются в списке свободных для следующих вставок
+    void clear() {
+        releaseTree(root);
+        root = nullptr;
+        treeSize = 0;
+    }
+
     //работает за O(log n)
     void insert(const TKey& key, const TValue& value) {
         root = insert(root, key, value);
@@ -271,9 +352,9 @@ public:
     TValue find(const TKey& key) const {
         Node* current = root;
         while (current) {
-            if (key < current->data.key) {
+            if (cmp(key, current->data.key)) {
                 current = current->left;
-            } else if (key > current->data.key) {
+            } else if (cmp(current->data.key, key)) {
                 current = current->right;
             } else {
                 return current->data.value;
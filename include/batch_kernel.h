@@ -0,0 +1,448 @@
+#ifndef OTREZKI_BATCH_KERNEL_H
+#define OTREZKI_BATCH_KERNEL_H
+
+#include <cstdint>
+#include <cmath>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define OTREZKI_BATCH_X86 1
+#include <immintrin.h>
+#endif
+
+// Набор команд, которым считается пакетная проверка
+enum BatchIsa {
+    BATCH_SCALAR,
+    BATCH_AVX2,
+    BATCH_AVX512
+};
+
+// Блок отрезков в виде массивов координат типа T (double, float или int32_t):
+// концы и габаритные прямоугольники (count <= BatchKernel::BLOCK)
+template <typename T>
+struct BatchBlockT {
+    const T* x0;
+    const T* y0;
+    const T* x1;
+    const T* y1;
+    const T* xmin;
+    const T* ymin;
+    const T* xmax;
+    const T* ymax;
+    int count;
+
+    BatchBlockT offset(int k) const {
+        return { x0 + k, y0 + k, x1 + k, y1 + k, xmin + k, ymin + k, xmax + k, ymax + k, count - k };
+    }
+};
+
+typedef BatchBlockT<double> BatchBlock;
+
+// Пакетная проверка "отрезок AB против блока отрезков" по массивам координат.
+// Сначала сравниваются габаритные прямоугольники; если хоть один отрезок группы из 4 double / 8 float (AVX2)
+// или 8 double / 16 float (AVX-512) прошёл, для группы без ветвлений считаются все четыре ориентации.
+// Целые координаты сравниваются по 8 (AVX2) или 16 (AVX-512) int32, ориентации - в double по половинам группы:
+// разности int32 в double точны, поэтому тот же запас на погрешность остаётся верным.
+// Результат - маска кандидатов: бит k сброшен, только если отрезок k заведомо не имеет общих точек с AB
+// (прямоугольники не пересекаются, либо все ориентации отделены от нуля с запасом на погрешность
+// и концы лежат по одну сторону). Остальные биты - собственные пересечения и вырожденные случаи,
+// их окончательно проверяет SetSectionT::intersection, поэтому маска не зависит от того, как компилятор
+// округлил выражения. Набор команд выбирается один раз при первом вызове по возможностям процессора
+class BatchKernel {
+public:
+    static const int BLOCK = 32;    // Максимальное число отрезков в одном вызове
+
+    template <typename T>
+    using Function = uint32_t(*)(T ax, T ay, T bx, T by, const BatchBlockT<T>& block);
+    template <typename T>
+    using ScanFunction = int(*)(T ax, T ay, T bx, T by, const BatchBlockT<T>& lanes, int from, uint32_t& mask);
+
+    // Кандидаты среди отрезков блока
+    template <typename T>
+    static uint32_t candidates(T ax, T ay, T bx, T by, const BatchBlockT<T>& block) {
+        static const Function<T> active = function<T>(detect());
+        return active(ax, ay, bx, by, block);
+    }
+
+    // Проход по длинному ряду отрезков lanes (count не ограничен) блоками по BLOCK начиная с from:
+    // возвращает начало первого блока с кандидатами и его маску в mask, lanes.count - если таких нет.
+    // Весь ряд проходит внутри одного вызова, поэтому выбор набора команд и подготовка AB не повторяются на каждом блоке
+    template <typename T>
+    static int scan(T ax, T ay, T bx, T by, const BatchBlockT<T>& lanes, int from, uint32_t& mask) {
+        static const ScanFunction<T> active = scanFunction<T>(detect());
+        return active(ax, ay, bx, by, lanes, from, mask);
+    }
+
+    // Лучший набор команд, доступный на этом процессоре
+    static BatchIsa detect() {
+#if defined(OTREZKI_BATCH_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return BATCH_AVX512;
+        if (__builtin_cpu_supports("avx2")) return BATCH_AVX2;
+#endif
+        return BATCH_SCALAR;
+    }
+
+    // Реализация для набора команд isa; недоступные на этой сборке заменяются скалярной
+    template <typename T>
+    static Function<T> function(BatchIsa isa) {
+#if defined(OTREZKI_BATCH_X86)
+        if (isa == BATCH_AVX512) return static_cast<Function<T>>(candidatesAvx512);
+        if (isa == BATCH_AVX2) return static_cast<Function<T>>(candidatesAvx2);
+#endif
+        (void)isa;
+        return candidatesScalar<T>;
+    }
+
+    template <typename T>
+    static ScanFunction<T> scanFunction(BatchIsa isa) {
+#if defined(OTREZKI_BATCH_X86)
+        if (isa == BATCH_AVX512) return static_cast<ScanFunction<T>>(scanAvx512);
+        if (isa == BATCH_AVX2) return static_cast<ScanFunction<T>>(scanAvx2);
+#endif
+        (void)isa;
+        return scanScalar<T>;
+    }
+
+    template <typename T>
+    static uint32_t candidatesScalar(T ax, T ay, T bx, T by, const BatchBlockT<T>& block) {
+        T x_min = ax < bx ? ax : bx, x_max = ax < bx ? bx : ax;
+        T y_min = ay < by ? ay : by, y_max = ay < by ? by : ay;
+        uint32_t mask = 0;
+        for (int k = 0; k < block.count; ++k) {
+            bool box = block.xmax[k] >= x_min && block.xmin[k] <= x_max && block.ymax[k] >= y_min && block.ymin[k] <= y_max;
+            if (box && candidate(ax, ay, bx, by, block.x0[k], block.y0[k], block.x1[k], block.y1[k])) {
+                mask |= uint32_t(1) << k;
+            }
+        }
+        return mask;
+    }
+
+    template <typename T>
+    static int scanScalar(T ax, T ay, T bx, T by, const BatchBlockT<T>& lanes, int from, uint32_t& mask) {
+        return scanBlocks<T>(ax, ay, bx, by, lanes, from, mask, candidatesScalar<T>);
+    }
+
+private:
+    template <typename T>
+    static int scanBlocks(T ax, T ay, T bx, T by, const BatchBlockT<T>& lanes, int from, uint32_t& mask, Function<T> block) {
+        for (int k = from; k < lanes.count; k += BLOCK) {
+            BatchBlockT<T> part = lanes.offset(k);
+            if (part.count > BLOCK) part.count = BLOCK;
+            mask = block(ax, ay, bx, by, part);
+            if (mask != 0) return k;
+        }
+        mask = 0;
+        return lanes.count;
+    }
+
+    // Относительный запас на ошибку округления ориентации: сумма модулей слагаемых, умноженная
+    // на него, заведомо больше ошибки как обычного вычисления, так и вычисления через FMA
+    // (около 8 единиц последнего разряда типа)
+    static double orientError(double) {
+        return 1e-15;
+    }
+
+    static float orientError(float) {
+        return 1e-6f;
+    }
+
+    static bool candidate(int32_t ax, int32_t ay, int32_t bx, int32_t by, int32_t cx, int32_t cy, int32_t dx, int32_t dy) {
+        return candidate<double>(ax, ay, bx, by, cx, cy, dx, dy);
+    }
+
+    template <typename T>
+    static bool candidate(T ax, T ay, T bx, T by, T cx, T cy, T dx, T dy) {
+        int far = 0;
+        bool p1 = orientPositive(ax, ay, bx, by, cx, cy, far);
+        bool p2 = orientPositive(ax, ay, bx, by, dx, dy, far);
+        bool p3 = orientPositive(cx, cy, dx, dy, ax, ay, far);
+        bool p4 = orientPositive(cx, cy, dx, dy, bx, by, far);
+        return far != 4 || (p1 != p2 && p3 != p4);
+    }
+
+    // Знак ориентации (B-A)x(C-A); far увеличивается, если она надёжно отделена от нуля
+    template <typename T>
+    static bool orientPositive(T ax, T ay, T bx, T by, T cx, T cy, int& far) {
+        T t1 = (bx - ax) * (cy - ay);
+        T t2 = (by - ay) * (cx - ax);
+        T det = t1 - t2;
+        far += std::abs(det) > orientError(T()) * (std::abs(t1) + std::abs(t2));
+        return det > 0;
+    }
+
+#if defined(OTREZKI_BATCH_X86)
+    // AVX2, double: группы по 4 отрезка
+    __attribute__((target("avx2")))
+    static __m256d orientAvx2(__m256d ax, __m256d ay, __m256d bx, __m256d by, __m256d cx, __m256d cy, __m256d& far) {
+        const __m256d sign = _mm256_set1_pd(-0.0);
+        __m256d t1 = _mm256_mul_pd(_mm256_sub_pd(bx, ax), _mm256_sub_pd(cy, ay));
+        __m256d t2 = _mm256_mul_pd(_mm256_sub_pd(by, ay), _mm256_sub_pd(cx, ax));
+        __m256d det = _mm256_sub_pd(t1, t2);
+        __m256d bound = _mm256_mul_pd(_mm256_set1_pd(orientError(0.0)),
+            _mm256_add_pd(_mm256_andnot_pd(sign, t1), _mm256_andnot_pd(sign, t2)));
+        far = _mm256_and_pd(far, _mm256_cmp_pd(_mm256_andnot_pd(sign, det), bound, _CMP_GT_OQ));
+        return _mm256_cmp_pd(det, _mm256_setzero_pd(), _CMP_GT_OQ);
+    }
+
+    __attribute__((target("avx2")))
+    static uint32_t candidatesAvx2(double ax, double ay, double bx, double by, const BatchBlockT<double>& block) {
+        __m256d Ax = _mm256_set1_pd(ax), Ay = _mm256_set1_pd(ay);
+        __m256d Bx = _mm256_set1_pd(bx), By = _mm256_set1_pd(by);
+        __m256d Xmin = _mm256_min_pd(Ax, Bx), Xmax = _mm256_max_pd(Ax, Bx);
+        __m256d Ymin = _mm256_min_pd(Ay, By), Ymax = _mm256_max_pd(Ay, By);
+        uint32_t mask = 0;
+        int k = 0;
+        for (; k + 4 <= block.count; k += 4) {
+            __m256d box = _mm256_and_pd(
+                _mm256_and_pd(_mm256_cmp_pd(_mm256_loadu_pd(block.xmax + k), Xmin, _CMP_GE_OQ),
+                    _mm256_cmp_pd(_mm256_loadu_pd(block.xmin + k), Xmax, _CMP_LE_OQ)),
+                _mm256_and_pd(_mm256_cmp_pd(_mm256_loadu_pd(block.ymax + k), Ymin, _CMP_GE_OQ),
+                    _mm256_cmp_pd(_mm256_loadu_pd(block.ymin + k), Ymax, _CMP_LE_OQ)));
+            int box_mask = _mm256_movemask_pd(box);
+            if (box_mask == 0) continue;
+
+            __m256d Cx = _mm256_loadu_pd(block.x0 + k), Cy = _mm256_loadu_pd(block.y0 + k);
+            __m256d Dx = _mm256_loadu_pd(block.x1 + k), Dy = _mm256_loadu_pd(block.y1 + k);
+            __m256d far = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+            __m256d p1 = orientAvx2(Ax, Ay, Bx, By, Cx, Cy, far);
+            __m256d p2 = orientAvx2(Ax, Ay, Bx, By, Dx, Dy, far);
+            __m256d p3 = orientAvx2(Cx, Cy, Dx, Dy, Ax, Ay, far);
+            __m256d p4 = orientAvx2(Cx, Cy, Dx, Dy, Bx, By, far);
+            __m256d proper = _mm256_and_pd(_mm256_xor_pd(p1, p2), _mm256_xor_pd(p3, p4));
+            __m256d rejected = _mm256_andnot_pd(proper, far);
+            mask |= uint32_t(box_mask & ~_mm256_movemask_pd(rejected)) << k;
+        }
+        return k < block.count ? mask | candidatesScalar(ax, ay, bx, by, block.offset(k)) << k : mask;
+    }
+
+    // AVX2, float: группы по 8 отрезков
+    __attribute__((target("avx2")))
+    static __m256 orientAvx2(__m256 ax, __m256 ay, __m256 bx, __m256 by, __m256 cx, __m256 cy, __m256& far) {
+        const __m256 sign = _mm256_set1_ps(-0.0f);
+        __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(bx, ax), _mm256_sub_ps(cy, ay));
+        __m256 t2 = _mm256_mul_ps(_mm256_sub_ps(by, ay), _mm256_sub_ps(cx, ax));
+        __m256 det = _mm256_sub_ps(t1, t2);
+        __m256 bound = _mm256_mul_ps(_mm256_set1_ps(orientError(0.0f)),
+            _mm256_add_ps(_mm256_andnot_ps(sign, t1), _mm256_andnot_ps(sign, t2)));
+        far = _mm256_and_ps(far, _mm256_cmp_ps(_mm256_andnot_ps(sign, det), bound, _CMP_GT_OQ));
+        return _mm256_cmp_ps(det, _mm256_setzero_ps(), _CMP_GT_OQ);
+    }
+
+    __attribute__((target("avx2")))
+    static uint32_t candidatesAvx2(float ax, float ay, float bx, float by, const BatchBlockT<float>& block) {
+        __m256 Ax = _mm256_set1_ps(ax), Ay = _mm256_set1_ps(ay);
+        __m256 Bx = _mm256_set1_ps(bx), By = _mm256_set1_ps(by);
+        __m256 Xmin = _mm256_min_ps(Ax, Bx), Xmax = _mm256_max_ps(Ax, Bx);
+        __m256 Ymin = _mm256_min_ps(Ay, By), Ymax = _mm256_max_ps(Ay, By);
+        uint32_t mask = 0;
+        int k = 0;
+        for (; k + 8 <= block.count; k += 8) {
+            __m256 box = _mm256_and_ps(
+                _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(block.xmax + k), Xmin, _CMP_GE_OQ),
+                    _mm256_cmp_ps(_mm256_loadu_ps(block.xmin + k), Xmax, _CMP_LE_OQ)),
+                _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(block.ymax + k), Ymin, _CMP_GE_OQ),
+                    _mm256_cmp_ps(_mm256_loadu_ps(block.ymin + k), Ymax, _CMP_LE_OQ)));
+            int box_mask = _mm256_movemask_ps(box);
+            if (box_mask == 0) continue;
+
+            __m256 Cx = _mm256_loadu_ps(block.x0 + k), Cy = _mm256_loadu_ps(block.y0 + k);
+            __m256 Dx = _mm256_loadu_ps(block.x1 + k), Dy = _mm256_loadu_ps(block.y1 + k);
+            __m256 far = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            __m256 p1 = orientAvx2(Ax, Ay, Bx, By, Cx, Cy, far);
+            __m256 p2 = orientAvx2(Ax, Ay, Bx, By, Dx, Dy, far);
+            __m256 p3 = orientAvx2(Cx, Cy, Dx, Dy, Ax, Ay, far);
+            __m256 p4 = orientAvx2(Cx, Cy, Dx, Dy, Bx, By, far);
+            __m256 proper = _mm256_and_ps(_mm256_xor_ps(p1, p2), _mm256_xor_ps(p3, p4));
+            __m256 rejected = _mm256_andnot_ps(proper, far);
+            mask |= uint32_t(box_mask & ~_mm256_movemask_ps(rejected)) << k;
+        }
+        return k < block.count ? mask | candidatesScalar(ax, ay, bx, by, block.offset(k)) << k : mask;
+    }
+
+    // AVX2, int32: прямоугольники группами по 8, ориентации по 4 в double
+    __attribute__((target("avx2")))
+    static int rejectedAvx2(__m256d Ax, __m256d Ay, __m256d Bx, __m256d By, const BatchBlockT<int32_t>& block, int k) {
+        __m256d Cx = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block.x0 + k)));
+        __m256d Cy = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block.y0 + k)));
+        __m256d Dx = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block.x1 + k)));
+        __m256d Dy = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block.y1 + k)));
+        __m256d far = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        __m256d p1 = orientAvx2(Ax, Ay, Bx, By, Cx, Cy, far);
+        __m256d p2 = orientAvx2(Ax, Ay, Bx, By, Dx, Dy, far);
+        __m256d p3 = orientAvx2(Cx, Cy, Dx, Dy, Ax, Ay, far);
+        __m256d p4 = orientAvx2(Cx, Cy, Dx, Dy, Bx, By, far);
+        __m256d proper = _mm256_and_pd(_mm256_xor_pd(p1, p2), _mm256_xor_pd(p3, p4));
+        return _mm256_movemask_pd(_mm256_andnot_pd(proper, far));
+    }
+
+    __attribute__((target("avx2")))
+    static uint32_t candidatesAvx2(int32_t ax, int32_t ay, int32_t bx, int32_t by, const BatchBlockT<int32_t>& block) {
+        __m256d Ax = _mm256_set1_pd(ax), Ay = _mm256_set1_pd(ay);
+        __m256d Bx = _mm256_set1_pd(bx), By = _mm256_set1_pd(by);
+        __m256i Xmin = _mm256_set1_epi32(ax < bx ? ax : bx), Xmax = _mm256_set1_epi32(ax < bx ? bx : ax);
+        __m256i Ymin = _mm256_set1_epi32(ay < by ? ay : by), Ymax = _mm256_set1_epi32(ay < by ? by : ay);
+        uint32_t mask = 0;
+        int k = 0;
+        for (; k + 8 <= block.count; k += 8) {
+            __m256i outside = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpgt_epi32(Xmin, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block.xmax + k))),
+                    _mm256_cmpgt_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block.xmin + k)), Xmax)),
+                _mm256_or_si256(_mm256_cmpgt_epi32(Ymin, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block.ymax + k))),
+                    _mm256_cmpgt_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block.ymin + k)), Ymax)));
+            int box_mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFF;
+            if (box_mask == 0) continue;
+
+            int rejected = rejectedAvx2(Ax, Ay, Bx, By, block, k) | rejectedAvx2(Ax, Ay, Bx, By, block, k + 4) << 4;
+            mask |= uint32_t(box_mask & ~rejected) << k;
+        }
+        return k < block.count ? mask | candidatesScalar(ax, ay, bx, by, block.offset(k)) << k : mask;
+    }
+
+    __attribute__((target("avx2")))
+    static int scanAvx2(double ax, double ay, double bx, double by, const BatchBlockT<double>& lanes, int from, uint32_t& mask) {
+        return scanBlocks<double>(ax, ay, bx, by, lanes, from, mask, candidatesAvx2);
+    }
+
+    __attribute__((target("avx2")))
+    static int scanAvx2(float ax, float ay, float bx, float by, const BatchBlockT<float>& lanes, int from, uint32_t& mask) {
+        return scanBlocks<float>(ax, ay, bx, by, lanes, from, mask, candidatesAvx2);
+    }
+
+    __attribute__((target("avx2")))
+    static int scanAvx2(int32_t ax, int32_t ay, int32_t bx, int32_t by, const BatchBlockT<int32_t>& lanes, int from, uint32_t& mask) {
+        return scanBlocks<int32_t>(ax, ay, bx, by, lanes, from, mask, candidatesAvx2);
+    }
+
+    // AVX-512, double: группы по 8 отрезков
+    __attribute__((target("avx512f")))
+    static void orientAvx512(__m512d ax, __m512d ay, __m512d bx, __m512d by, __m512d cx, __m512d cy, __mmask8& far, __mmask8& positive) {
+        __m512d t1 = _mm512_mul_pd(_mm512_sub_pd(bx, ax), _mm512_sub_pd(cy, ay));
+        __m512d t2 = _mm512_mul_pd(_mm512_sub_pd(by, ay), _mm512_sub_pd(cx, ax));
+        __m512d det = _mm512_sub_pd(t1, t2);
+        __m512d bound = _mm512_mul_pd(_mm512_set1_pd(orientError(0.0)), _mm512_add_pd(_mm512_abs_pd(t1), _mm512_abs_pd(t2)));
+        far &= _mm512_cmp_pd_mask(_mm512_abs_pd(det), bound, _CMP_GT_OQ);
+        positive = _mm512_cmp_pd_mask(det, _mm512_setzero_pd(), _CMP_GT_OQ);
+    }
+
+    __attribute__((target("avx512f")))
+    static uint32_t candidatesAvx512(double ax, double ay, double bx, double by, const BatchBlockT<double>& block) {
+        __m512d Ax = _mm512_set1_pd(ax), Ay = _mm512_set1_pd(ay);
+        __m512d Bx = _mm512_set1_pd(bx), By = _mm512_set1_pd(by);
+        __m512d Xmin = _mm512_min_pd(Ax, Bx), Xmax = _mm512_max_pd(Ax, Bx);
+        __m512d Ymin = _mm512_min_pd(Ay, By), Ymax = _mm512_max_pd(Ay, By);
+        uint32_t mask = 0;
+        int k = 0;
+        for (; k + 8 <= block.count; k += 8) {
+            __mmask8 box = _mm512_cmp_pd_mask(_mm512_loadu_pd(block.xmax + k), Xmin, _CMP_GE_OQ);
+            box = _mm512_mask_cmp_pd_mask(box, _mm512_loadu_pd(block.xmin + k), Xmax, _CMP_LE_OQ);
+            box = _mm512_mask_cmp_pd_mask(box, _mm512_loadu_pd(block.ymax + k), Ymin, _CMP_GE_OQ);
+            box = _mm512_mask_cmp_pd_mask(box, _mm512_loadu_pd(block.ymin + k), Ymax, _CMP_LE_OQ);
+            if (box == 0) continue;
+
+            __m512d Cx = _mm512_loadu_pd(block.x0 + k), Cy = _mm512_loadu_pd(block.y0 + k);
+            __m512d Dx = _mm512_loadu_pd(block.x1 + k), Dy = _mm512_loadu_pd(block.y1 + k);
+            __mmask8 far = 0xFF, p1, p2, p3, p4;
+            orientAvx512(Ax, Ay, Bx, By, Cx, Cy, far, p1);
+            orientAvx512(Ax, Ay, Bx, By, Dx, Dy, far, p2);
+            orientAvx512(Cx, Cy, Dx, Dy, Ax, Ay, far, p3);
+            orientAvx512(Cx, Cy, Dx, Dy, Bx, By, far, p4);
+            __mmask8 proper = (p1 ^ p2) & (p3 ^ p4);
+            mask |= uint32_t(uint8_t(box & ~(far & ~proper))) << k;
+        }
+        return k < block.count ? mask | candidatesScalar(ax, ay, bx, by, block.offset(k)) << k : mask;
+    }
+
+    // AVX-512, float: группы по 16 отрезков - весь блок за один шаг
+    __attribute__((target("avx512f")))
+    static void orientAvx512(__m512 ax, __m512 ay, __m512 bx, __m512 by, __m512 cx, __m512 cy, __mmask16& far, __mmask16& positive) {
+        __m512 t1 = _mm512_mul_ps(_mm512_sub_ps(bx, ax), _mm512_sub_ps(cy, ay));
+        __m512 t2 = _mm512_mul_ps(_mm512_sub_ps(by, ay), _mm512_sub_ps(cx, ax));
+        __m512 det = _mm512_sub_ps(t1, t2);
+        __m512 bound = _mm512_mul_ps(_mm512_set1_ps(orientError(0.0f)), _mm512_add_ps(_mm512_abs_ps(t1), _mm512_abs_ps(t2)));
+        far &= _mm512_cmp_ps_mask(_mm512_abs_ps(det), bound, _CMP_GT_OQ);
+        positive = _mm512_cmp_ps_mask(det, _mm512_setzero_ps(), _CMP_GT_OQ);
+    }
+
+    __attribute__((target("avx512f")))
+    static uint32_t candidatesAvx512(float ax, float ay, float bx, float by, const BatchBlockT<float>& block) {
+        __m512 Ax = _mm512_set1_ps(ax), Ay = _mm512_set1_ps(ay);
+        __m512 Bx = _mm512_set1_ps(bx), By = _mm512_set1_ps(by);
+        __m512 Xmin = _mm512_min_ps(Ax, Bx), Xmax = _mm512_max_ps(Ax, Bx);
+        __m512 Ymin = _mm512_min_ps(Ay, By), Ymax = _mm512_max_ps(Ay, By);
+        uint32_t mask = 0;
+        int k = 0;
+        for (; k + 16 <= block.count; k += 16) {
+            __mmask16 box = _mm512_cmp_ps_mask(_mm512_loadu_ps(block.xmax + k), Xmin, _CMP_GE_OQ);
+            box = _mm512_mask_cmp_ps_mask(box, _mm512_loadu_ps(block.xmin + k), Xmax, _CMP_LE_OQ);
+            box = _mm512_mask_cmp_ps_mask(box, _mm512_loadu_ps(block.ymax + k), Ymin, _CMP_GE_OQ);
+            box = _mm512_mask_cmp_ps_mask(box, _mm512_loadu_ps(block.ymin + k), Ymax, _CMP_LE_OQ);
+            if (box == 0) continue;
+
+            __m512 Cx = _mm512_loadu_ps(block.x0 + k), Cy = _mm512_loadu_ps(block.y0 + k);
+            __m512 Dx = _mm512_loadu_ps(block.x1 + k), Dy = _mm512_loadu_ps(block.y1 + k);
+            __mmask16 far = 0xFFFF, p1, p2, p3, p4;
+            orientAvx512(Ax, Ay, Bx, By, Cx, Cy, far, p1);
+            orientAvx512(Ax, Ay, Bx, By, Dx, Dy, far, p2);
+            orientAvx512(Cx, Cy, Dx, Dy, Ax, Ay, far, p3);
+            orientAvx512(Cx, Cy, Dx, Dy, Bx, By, far, p4);
+            __mmask16 proper = (p1 ^ p2) & (p3 ^ p4);
+            mask |= uint32_t(uint16_t(box & ~(far & ~proper))) << k;
+        }
+        return k < block.count ? mask | candidatesScalar(ax, ay, bx, by, block.offset(k)) << k : mask;
+    }
+
+    // AVX-512, int32: прямоугольники группами по 16, ориентации по 8 в double
+    __attribute__((target("avx512f")))
+    static __mmask8 rejectedAvx512(__m512d Ax, __m512d Ay, __m512d Bx, __m512d By, const BatchBlockT<int32_t>& block, int k) {
+        __m512d Cx = _mm512_cvtepi32_pd(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block.x0 + k)));
+        __m512d Cy = _mm512_cvtepi32_pd(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block.y0 + k)));
+        __m512d Dx = _mm512_cvtepi32_pd(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block.x1 + k)));
+        __m512d Dy = _mm512_cvtepi32_pd(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block.y1 + k)));
+        __mmask8 far = 0xFF, p1, p2, p3, p4;
+        orientAvx512(Ax, Ay, Bx, By, Cx, Cy, far, p1);
+        orientAvx512(Ax, Ay, Bx, By, Dx, Dy, far, p2);
+        orientAvx512(Cx, Cy, Dx, Dy, Ax, Ay, far, p3);
+        orientAvx512(Cx, Cy, Dx, Dy, Bx, By, far, p4);
+        return far & ~((p1 ^ p2) & (p3 ^ p4));
+    }
+
+    __attribute__((target("avx512f")))
+    static uint32_t candidatesAvx512(int32_t ax, int32_t ay, int32_t bx, int32_t by, const BatchBlockT<int32_t>& block) {
+        __m512d Ax = _mm512_set1_pd(ax), Ay = _mm512_set1_pd(ay);
+        __m512d Bx = _mm512_set1_pd(bx), By = _mm512_set1_pd(by);
+        __m512i Xmin = _mm512_set1_epi32(ax < bx ? ax : bx), Xmax = _mm512_set1_epi32(ax < bx ? bx : ax);
+        __m512i Ymin = _mm512_set1_epi32(ay < by ? ay : by), Ymax = _mm512_set1_epi32(ay < by ? by : ay);
+        uint32_t mask = 0;
+        int k = 0;
+        for (; k + 16 <= block.count; k += 16) {
+            __mmask16 box = _mm512_cmp_epi32_mask(_mm512_loadu_si512(block.xmax + k), Xmin, _MM_CMPINT_NLT);
+            box = _mm512_mask_cmp_epi32_mask(box, _mm512_loadu_si512(block.xmin + k), Xmax, _MM_CMPINT_LE);
+            box = _mm512_mask_cmp_epi32_mask(box, _mm512_loadu_si512(block.ymax + k), Ymin, _MM_CMPINT_NLT);
+            box = _mm512_mask_cmp_epi32_mask(box, _mm512_loadu_si512(block.ymin + k), Ymax, _MM_CMPINT_LE);
+            if (box == 0) continue;
+
+            uint32_t rejected = uint32_t(rejectedAvx512(Ax, Ay, Bx, By, block, k)) |
+                uint32_t(rejectedAvx512(Ax, Ay, Bx, By, block, k + 8)) << 8;
+            mask |= (uint32_t(box) & ~rejected) << k;
+        }
+        return k < block.count ? mask | candidatesScalar(ax, ay, bx, by, block.offset(k)) << k : mask;
+    }
+
+    __attribute__((target("avx512f")))
+    static int scanAvx512(double ax, double ay, double bx, double by, const BatchBlockT<double>& lanes, int from, uint32_t& mask) {
+        return scanBlocks<double>(ax, ay, bx, by, lanes, from, mask, candidatesAvx512);
+    }
+
+    __attribute__((target("avx512f")))
+    static int scanAvx512(float ax, float ay, float bx, float by, const BatchBlockT<float>& lanes, int from, uint32_t& mask) {
+        return scanBlocks<float>(ax, ay, bx, by, lanes, from, mask, candidatesAvx512);
+    }
+
+    __attribute__((target("avx512f")))
+    static int scanAvx512(int32_t ax, int32_t ay, int32_t bx, int32_t by, const BatchBlockT<int32_t>& lanes, int from, uint32_t& mask) {
+        return scanBlocks<int32_t>(ax, ay, bx, by, lanes, from, mask, candidatesAvx512);
+    }
+#endif
+};
+
+#endif // OTREZKI_BATCH_KERNEL_H
@@ -0,0 +1,40 @@
+#ifndef OTREZKI_FENWICK_TREE_H
+#define OTREZKI_FENWICK_TREE_H
+
+#include <vector>
+
+// Дерево Фенвика (двоичное индексированное дерево): прибавление в точке и сумма на префиксе за O(log n)
+template <typename TValue = long long>
+class FenwickTree {
+    std::vector<TValue> tree;
+
+public:
+    explicit FenwickTree(int n = 0) : tree(n + 1, TValue()) {}
+
+    // Обнуление с новым размером без лишних выделений памяти
+    void reset(int n) {
+        tree.assign(n + 1, TValue());
+    }
+
+    int size() const {
+        return int(tree.size()) - 1;
+    }
+
+    // Прибавить delta к элементу i (нумерация с нуля)
+    void add(int i, TValue delta) {
+        for (++i; i < tree.size(); i += i & -i) {
+            tree[i] += delta;
+        }
+    }
+
+    // Сумма элементов [0, i)
+    TValue prefix(int i) const {
+        TValue sum = TValue();
+        for (; i > 0; i -= i & -i) {
+            sum += tree[i];
+        }
+        return sum;
+    }
+};
+
+#endif // OTREZKI_FENWICK_TREE_H
@@ -7,437 +7,2597 @@
 #include <cmath>
 #include <limits>
 #include <chrono>
+#include <set>
+#include <utility>
+#include <stdexcept>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <type_traits>
 #include "avl_tree.h"
+#include "sweep_status.h"
+#include "fenwick_tree.h"
+#include "rank_set.h"
+#include "aligned_array.h"
+#include "batch_kernel.h"
+#include "wide_int.h"
+#include "robust_predicates.h"
+#include "radix_sort.h"
 
 #define M_PI 3.14159265358979323846
 
-// Точка на плоскости в декартовой системе координат
-struct point {
+// Точка на плоскости в декартовой системе координат; T - тип координат (double или float)
+template <typename T>
+struct pointT {
+    T x;
+    T y;
+
+    // Лексикографическое сравнение, т е по x потом по y
+    bool operator<(const pointT& other) const {
+        return (x < other.x) || (x == other.x && y < other.y);
+    }
+
+    bool operator==(const pointT& other) const {
+        return x == other.x && y == other.y;
+    }
+};
+
+// Отрезок на плоскости
+template <typename T>
+struct sectionT {
+    pointT<T> begin;
+    pointT<T> end;
+
+    bool operator==(const sectionT& other) const {
+        return begin == other.begin && end == other.end;
+    }
+};
+
+typedef pointT<double> point;
+typedef sectionT<double> section;
+
+// Отрезки набора по отдельным массивам координат (SoA): отрезок i - (x0[i], y0[i]) - (x1[i], y1[i]).
+// Проход по одной координате читает подряд идущую память и векторизуется без сборки из структур
+template <typename T>
+struct SectionViewT {
+    const T* x0;
+    const T* y0;
+    const T* x1;
+    const T* y1;
+    const T* xmin;     // Габаритные прямоугольники отрезков
+    const T* ymin;
+    const T* xmax;
+    const T* ymax;
+    int n;
+
+    sectionT<T> operator[](int i) const {
+        return { { x0[i], y0[i] }, { x1[i], y1[i] } };
+    }
+
+    // Отрезки [j, j + count) для BatchKernel
+    BatchBlockT<T> block(int j, int count) const {
+        return { x0 + j, y0 + j, x1 + j, y1 + j, xmin + j, ymin + j, xmax + j, ymax + j, count };
+    }
+};
+
+typedef SectionViewT<double> SectionView;
+
+// Хранилище SoA-копии отрезков: восемь массивов, каждый выровнен на 64 байта
+template <typename T>
+class SectionArraysT {
+    AlignedArray<T> x0, y0, x1, y1;
+    AlignedArray<T> xmin, ymin, xmax, ymax;
+
+public:
+    void assign(const std::vector<sectionT<T>>& sections) {
+        size_t n = sections.size();
+        for (AlignedArray<T>* lane : { &x0, &y0, &x1, &y1, &xmin, &ymin, &xmax, &ymax }) {
+            lane->resize(n);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            x0[i] = sections[i].begin.x;
+            y0[i] = sections[i].begin.y;
+            x1[i] = sections[i].end.x;
+            y1[i] = sections[i].end.y;
+            xmin[i] = std::min(x0[i], x1[i]);
+            ymin[i] = std::min(y0[i], y1[i]);
+            xmax[i] = std::max(x0[i], x1[i]);
+            ymax[i] = std::max(y0[i], y1[i]);
+        }
+    }
+
+    SectionViewT<T> view() const {
+        return { x0.data(), y0.data(), x1.data(), y1.data(),
+            xmin.data(), ymin.data(), xmax.data(), ymax.data(), int(x0.size()) };
+    }
+};
+
+// Компактное событие заметающей прямой: номер отрезка в младших 31 битах, старший бит взведён у правого
+// конца. Точка события не хранится - это левый (лексикографически меньший) или правый конец отрезка,
+// поэтому событие занимает 4 байта вместо 24 у Event, а упорядочивается по отдельно извлечённым ключам
+struct CompactEvent {
+    static const uint32_t RIGHT = uint32_t(1) << 31;
+
+    uint32_t code;
+
+    static CompactEvent left(int segment) {
+        return { uint32_t(segment) };
+    }
+
+    static CompactEvent right(int segment) {
+        return { uint32_t(segment) | RIGHT };
+    }
+
+    int segment() const {
+        return int(code & ~RIGHT);
+    }
+
+    bool isLeft() const {
+        return !(code & RIGHT);
+    }
+
+    // Поразрядная сортировка событий (значений Value - номеров или кодов) по их точкам point_of(value):
+    // сначала все по x ключом RadixSort::orderedKey, затем каждая группа с равным x - по y. Сортировки
+    // устойчивы, поэтому если в values левые концы стоят раньше правых, то в одной точке левые концы
+    // идут раньше правых, а равные события сохраняют исходный порядок.
+    // -0.0 и +0.0 равны, NaN - после всех чисел (см. RadixSort::orderedKey).
+    // Ключи извлекаются и сортируются в threads потоков; результат от числа потоков не зависит
+    template <typename Value, typename PointOf>
+    static void sortByPoint(std::vector<Value>& values, PointOf point_of, int threads = 1) {
+        Buffers<Value> buffers;
+        sortByPoint(values, point_of, threads, buffers);
+    }
+
+    // Рабочие буферы sortByPoint; переданные снова, они не перераспределяются, пока хватает ёмкости
+    template <typename Value>
+    struct Buffers {
+        std::vector<uint64_t> keys;
+        std::vector<uint64_t> keys_buffer;
+        std::vector<Value> values_buffer;
+        std::vector<uint64_t> run_keys;
+        std::vector<Value> run_values;
+    };
+
+    template <typename Value, typename PointOf>
+    static void sortByPoint(std::vector<Value>& values, PointOf point_of, int threads, Buffers<Value>& buffers) {
+        size_t n = values.size();
+        if (n < 2) return;
+
+        std::vector<uint64_t>& keys = buffers.keys;
+        keys.resize(n);
+        forEachRange(n, threads, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                keys[k] = RadixSort::orderedKey(point_of(values[k]).x);
+            }
+            });
+        RadixSort::sortPairs(keys, values, buffers.keys_buffer, buffers.values_buffer, threads);
+
+        // Группы с равным x (общие концы, вертикальные отрезки): на общих данных короткие, поэтому
+        // сортируются вставками; длинные (целочисленные сетки) - тоже поразрядно
+        std::vector<uint64_t>& run_keys = buffers.run_keys;
+        std::vector<Value>& run_values = buffers.run_values;
+        for (size_t begin = 0, end; begin < n; begin = end) {
+            end = begin + 1;
+            while (end < n && keys[end] == keys[begin]) ++end;
+            if (end - begin < 2) continue;
+
+            run_keys.resize(end - begin);
+            run_values.assign(values.begin() + begin, values.begin() + end);
+            for (size_t k = 0; k < run_keys.size(); ++k) {
+                run_keys[k] = RadixSort::orderedKey(point_of(run_values[k]).y);
+            }
+            if (run_keys.size() > 32) {
+                RadixSort::sortPairs(run_keys, run_values, buffers.keys_buffer, buffers.values_buffer);
+            }
+            else {
+                for (size_t k = 1; k < run_keys.size(); ++k) {
+                    uint64_t key = run_keys[k];
+                    Value value = run_values[k];
+                    size_t m = k;
+                    for (; m > 0 && run_keys[m - 1] > key; --m) {
+                        run_keys[m] = run_keys[m - 1];
+                        run_values[m] = run_values[m - 1];
+                    }
+                    run_keys[m] = key;
+                    run_values[m] = value;
+                }
+            }
+            std::copy(run_values.begin(), run_values.end(), values.begin() + begin);
+        }
+    }
+
+    // work(begin, end) по равным непрерывным частям [0, n) в threads потоках; на малых n - в одном
+    template <typename Work>
+    static void forEachRange(size_t n, int threads, Work work) {
+        if (threads < 1 || n < size_t(threads) * 16384) threads = 1;
+        size_t part = (n + threads - 1) / threads;
+        RadixSort::forEachPart(threads, [&](int t) {
+            work(std::min(n, t * part), std::min(n, (t + 1) * part));
+            });
+    }
+};
+
+// Структура для события - точки конца отрезка(для заметающей прямой).
+// Заметающая прямая всегда работает в double, в том числе для наборов с координатами float
+struct Event {
+    point p;            // Точка события
+    int segment_index;  // Индекс отрезка
+    bool is_left;       // true - левый конец, false - правый конец
+    
+    int segment() const {
+        return segment_index;
+    }
+
+    bool isLeft() const {
+        return is_left;
+    }
+
+    // Лексикографическое сравнение, т е по x потом по y;
+    // в одной точке левые концы идут раньше правых, чтобы касание концами не проскочило мимо дерева
+    bool operator<(const Event& other) const {
+        if (p.x != other.p.x) return p.x < other.p.x;
+        if (p.y != other.p.y) return p.y < other.p.y;
+        return is_left && !other.is_left;
+    }
+
+    // Сортировка событий в порядке operator< (CompactEvent::sortByPoint над номерами событий, где левые
+    // концы стоят раньше правых): равные события остаются в исходном порядке, то есть по номеру отрезка.
+    // Результат не зависит от числа потоков threads
+    static void sort(std::vector<Event>& events, int threads = 1) {
+        size_t n = events.size();
+        if (n < 2) return;
+
+        std::vector<uint32_t> order;
+        order.reserve(n);
+        for (int left = 1; left >= 0; --left) {
+            for (size_t k = 0; k < n; ++k) {
+                if (events[k].is_left == bool(left)) order.push_back(uint32_t(k));
+            }
+        }
+        CompactEvent::sortByPoint(order, [&](uint32_t k) { return events[k].p; }, threads);
+
+        std::vector<Event> sorted(n);
+        CompactEvent::forEachRange(n, threads, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                sorted[k] = events[order[k]];
+            }
+            });
+        events.swap(sorted);
+    }
+};
+
+// Общая часть пары пересекающихся отрезков: точка (begin == end) или, у коллинеарных
+// с наложением, отрезок наложения
+struct Crossing {
+    point begin;
+    point end;
+};
+
+// Какие касания отрезков считать пересечением; флаги объединяются через |.
+// Собственное пересечение (во внутренних точках обоих отрезков) считается всегда
+enum TouchPolicy {
+    TOUCH_NONE = 0,                 // только собственные пересечения
+    TOUCH_SHARED_ENDPOINT = 1,      // общий конец (узел сети)
+    TOUCH_ENDPOINT_ON_INTERIOR = 2, // конец одного отрезка во внутренней точке другого (примыкание)
+    TOUCH_COLLINEAR_OVERLAP = 4,    // наложение коллинеарных отрезков на участке ненулевой длины
+    TOUCH_ALL = 7,                  // любая общая точка (по умолчанию)
+
+    CONTACT_PROPER = 8              // вид общей точки из contactKind, а не флаг политики
+};
+
+// Дешёвая статистика набора для выбора алгоритма (считается за один проход)
+struct SetStatistics {
+    int n;
+    double mean_length;
+    double width;           // Габаритный прямоугольник набора
+    double height;
+    double axis_parallel;   // Доля горизонтальных и вертикальных отрезков
+};
+
+// Алгоритмы поиска пересечения
+enum SearchEngine {
+    ENGINE_NAIVE,           // перебор пар
+    ENGINE_GRID,            // равномерная сетка
+    ENGINE_SWEEP,           // заметающая прямая (Шамос–Хоуи)
+    ENGINE_ORTHOGONAL,      // проход для горизонталей и вертикалей
+    ENGINE_PRUNE            // sweep-and-prune по x-интервалам
+};
+
+// Кривая, заполняющая плоскость, для SetSection::reorderSpatially
+enum SpaceCurve {
+    CURVE_MORTON,           // Z-порядок: чередование битов координат
+    CURVE_HILBERT           // кривая Гильберта: соседние коды всегда соседние клетки
+};
+
+// Модель стоимости алгоритмов поиска пересечения: секунды на единицу работы.
+// Значения по умолчанию сняты на x86-64 (-O2); SetSection::calibrateCostModel() измеряет их на текущей машине
+struct CostModel {
+    double naive_pair = 2e-8;           // проверка одной пары в переборе
+    double sweep_event = 4.5e-8;        // событие прохода, на log2 числа событий (сортировка и АВЛ-дерево)
+    double orthogonal_event = 1.3e-8;   // событие прохода для горизонталей и вертикалей, на log2
+    double grid_item = 5e-8;            // занесение отрезка в клетку
+    double grid_pair = 2e-8;            // проверка пары внутри клетки
+    double prune_item = 1.5e-8;         // сортировка по левому краю, на log2 числа отрезков
+    double prune_pair = 2e-8;           // проверка пары с пересекающимися x-интервалами
+
+    double naive(const SetStatistics& st) const {
+        return naive_pair * 0.5 * st.n * (st.n - 1.0);
+    }
+
+    double sweep(const SetStatistics& st) const {
+        double events = 2.0 * st.n;
+        return sweep_event * events * std::log2(events);
+    }
+
+    double orthogonal(const SetStatistics& st) const {
+        if (st.axis_parallel < 1.0) return std::numeric_limits<double>::infinity();
+        double events = 2.0 * st.n;
+        return orthogonal_event * events * std::log2(events);
+    }
+
+    // Сторона клетки выбирается так же, как в SetSection::reportGridIntersections; отрезок случайного
+    // направления длины L задевает около (1 + 0.64 L/h)^2 клеток, пары считаются при равномерной плотности
+    double grid(const SetStatistics& st) const {
+        double n = st.n;
+        double h = std::max({ st.mean_length, std::sqrt(st.width * st.height / (2.0 * n)),
+            st.width / (2.0 * n), st.height / (2.0 * n) });
+        double cells = (std::floor(st.width / h) + 1) * (std::floor(st.height / h) + 1);
+        double per_segment = (1 + 0.64 * st.mean_length / h) * (1 + 0.64 * st.mean_length / h);
+        double items = n * per_segment;
+        return grid_item * (items + cells) + grid_pair * items * items / (2.0 * cells);
+    }
+
+    // x-проекция отрезка случайного направления - около 0.64 L, и при равномерной плотности
+    // x-интервалы пересекаются у доли пар около 2 * 0.64 L / ширина
+    double prune(const SetStatistics& st) const {
+        double n = st.n;
+        double share = st.width > 0 ? std::min(1.0, 2 * 0.64 * st.mean_length / st.width) : 1.0;
+        return prune_item * n * std::log2(n) + prune_pair * 0.5 * n * (n - 1.0) * share;
+    }
+};
+
+template <typename T>
+class SetSectionT;
+
+// Событие прохода для горизонталей и вертикалей (reportOrthogonalIntersections)
+struct OrthogonalEvent {
     double x;
-    double y;
+    int type;   // 0 - начало горизонтали, 1 - вертикаль, 2 - конец горизонтали
+    int id;
+};
+
+// Рабочая память поиска первого пересечения: буферы сортировки событий, статус заметающей прямой
+// с пулом узлов дерева, буфер отрезков, проходящих через точку события, упорядоченная копия отрезков
+// для sweep-and-prune, CSR-массивы сетки и массивы прохода для горизонталей и вертикалей.
+// Передаётся в findIntersection (любым алгоритмом), intersectionEffective, intersectionPrune,
+// intersectionGrid, firstOrthogonalIntersection и в report-функции тех же алгоритмов и переиспользуется
+// между вызовами и между наборами: буферы только растут, поэтому после вызовов на самом большом наборе
+// поиск в одном потоке не обращается к куче. Пары при переборе получает sink вызывающего кода, так что
+// и их хранение - в его руках. Перечисление всех пересечений Бентли–Оттманом (allIntersections,
+// countIntersections, красно-синий режим) и параллельные режимы рабочую память не принимают: очередь
+// точек пересечения и потоки выделяются на каждый вызов. Один объект - для одного потока
+template <typename T>
+class SweepWorkspaceT {
+    friend class SetSectionT<T>;
+
+    CompactEvent::Buffers<CompactEvent> sort_buffers;
+    std::vector<ExactLine> exact;
+    std::vector<int> through;
+    SweepStatus status;
+
+    std::vector<int> order;
+    std::vector<sectionT<T>> sorted;
+    SectionArraysT<T> lanes;
+
+    std::vector<int> grid_start;
+    std::vector<int> grid_items;
+    std::vector<int> grid_fill;
+
+    std::vector<int> horizontal;
+    std::vector<int> vertical;
+    std::vector<int> collinear_active;
+    std::vector<double> ys;
+    std::vector<int> rank;
+    std::vector<OrthogonalEvent> orthogonal_events;
+    std::vector<int> head;
+    std::vector<int> next;
+    std::vector<int> prev;
+    RankSet occupied;
+
+public:
+    SweepWorkspaceT() = default;
+    SweepWorkspaceT(const SweepWorkspaceT&) = delete;
+    SweepWorkspaceT& operator=(const SweepWorkspaceT&) = delete;
+};
+
+typedef SweepWorkspaceT<double> SweepWorkspace;
+
+// Набор отрезков с координатами типа T. Координаты хранятся в T (float вдвое сокращает память и вдвое
+// расширяет векторные проверки), а вычисления, где важна точность - ориентация, точки пересечения,
+// заметающая прямая, - ведутся в double. Для целых координат int32 (фиксированная точка) ориентация
+// и порядок на заметающей прямой Шамоса–Хоуи считаются точно в 64/128-битной арифметике
+template <typename T>
+class SetSectionT {
+    static_assert(std::is_floating_point<T>::value || std::is_same<T, int32_t>::value,
+        "SetSectionT: coordinates must be floating point or int32_t");
+
+public:
+    typedef T coord_type;
+    typedef pointT<T> point;
+    typedef sectionT<T> section;
+    typedef SectionViewT<T> SectionView;
+
+private:
+    std::vector<section> S;
+    int touch_policy = TOUCH_ALL;
+    int sort_threads = 1;
+    CostModel cost_model;
+
+    // SoA-копия S для проходов по координатам; строится при первом обращении после изменения набора
+    mutable SectionArraysT<T> arrays;
+
+    // Отсортированные компактные события и коэффициенты прямых для intersectionEffective: строятся
+    // при первом обращении после изменения набора (или в prepare()) и переживают повторные вызовы
+    mutable std::vector<CompactEvent> sorted_events;
+    mutable std::vector<LineCoeffs> sweep_lines;
+
+    // Флаги актуальности кэшей и мьютекс их построения: константные запросы из нескольких потоков
+    // строят кэш один раз, остальные ждут его и дальше только читают. Флаг проверяется без блокировки,
+    // поэтому готовый кэш мьютекс не трогает. Копия набора получает свой мьютекс и те же флаги
+    struct CacheState {
+        std::mutex mutex;
+        std::atomic<bool> arrays_valid{ false };
+        std::atomic<bool> events_valid{ false };
+
+        CacheState() = default;
+        CacheState(const CacheState& other) : arrays_valid(other.arrays_valid.load()), events_valid(other.events_valid.load()) {}
+        CacheState& operator=(const CacheState& other) {
+            arrays_valid = other.arrays_valid.load();
+            events_valid = other.events_valid.load();
+            return *this;
+        }
+    };
+    mutable CacheState cache;
+
+    // После reorderSpatially: исходный индекс отрезка на каждой позиции S и обратная перестановка.
+    // Пусто - отрезки лежат в порядке добавления
+    std::vector<int> original;
+    std::vector<int> position;
+
+    // Набор изменился: SoA-копия и кэш событий устарели. Изменять набор одновременно с запросами нельзя
+    void invalidate() {
+        cache.arrays_valid = false;
+        cache.events_valid = false;
+    }
+
+    void clearSections() {
+        S.clear();
+        invalidate();
+        original.clear();
+        position.clear();
+    }
+
+    void pushSection(const section& sec) {
+        invalidate();
+        if (!original.empty()) {
+            original.push_back(int(S.size()));
+            position.push_back(int(S.size()));
+        }
+        S.push_back(sec);
+    }
+
+    // Пара позиций в S как пара исходных индексов i < j
+    template <typename Sink>
+    bool reportOriginal(Sink& sink, int i, int j) const {
+        int a = originalIndex(i), b = originalIndex(j);
+        return a < b ? sink(a, b) : sink(b, a);
+    }
+
+public:
+    SetSectionT() = default;
+
+    SetSectionT(point A, point B) {
+        section AB;
+        AB.begin = A;
+        AB.end = B;
+        if (AB.begin == AB.end) {
+            throw std::runtime_error("Section is point");
+        }
+        S.push_back(AB);
+    }
+
+    void add_section(section sec) {
+        if (sec.begin == sec.end) {
+            throw std::runtime_error("It's point");
+        }
+        pushSection(sec);
+    }
+
+    void add_section(point A, point B) {
+        section AB{ A, B };
+        if (AB.begin == AB.end) {
+            throw std::runtime_error("Section is point");
+        }
+        pushSection(AB);
+    }
+
+    size_t size() const {
+        return S.size();
+    }
+
+    // Верхняя граница координат генераторов по умолчанию; целые, как и при калибровке, берутся в квадрате 10^6 x 10^6
+    static double generatorRange() {
+        return std::is_integral<T>::value ? 1e6 : 1.0;
+    }
+
+private:
+    // Координата генератора: целая округляется, а не отсекается
+    static T toCoord(double value) {
+        return std::is_integral<T>::value ? T(std::round(value)) : T(value);
+    }
+
+    // Ширина области или длина отрезков генератора: целые координаты при размере меньше 1
+    // стягивали бы отрезки в точки
+    static void checkGeneratorSize(double size) {
+        if (!(size > 0) || (std::is_integral<T>::value && size < 1)) {
+            throw std::runtime_error("Section is point");
+        }
+    }
+
+    // Отрезок генератора заносится в набор, только если он не вырожден в точку
+    bool pushGenerated(const section& sec) {
+        if (sec.begin == sec.end) return false;
+        S.push_back(sec);
+        return true;
+    }
+
+public:
+    // Случайные координаты начала и конца; отрезок, концы которого совпали, разыгрывается заново
+    void generate_random_sections(int n, double min_coord = 0.0, double max_coord = generatorRange()) {
+        clearSections();
+        checkGeneratorSize(max_coord - min_coord);
+
+        while (int(S.size()) < n) {
+            section sec;
+
+            // Генерируем случайные координаты для начала отрезка
+            // Делим случайное число rand на RAND_MAX(2^15-1) и получаем дробное число от 0 до 1
+            sec.begin.x = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+            sec.begin.y = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+
+            // Генерируем случайные координаты для конца отрезка
+            sec.end.x = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+            sec.end.y = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+
+            pushGenerated(sec);
+        }
+    }
+
+    //генерация отрезков заданной длины со случайными центрами и углами
+    void generate_sections_fixed_length(int n, double segment_length, double min_coord = 0.0, double max_coord = generatorRange()) {
+        clearSections();
+        checkGeneratorSize(segment_length);
+
+        while (int(S.size()) < n) {
+            section sec;
+
+            // Генерируем случайные координаты центра отрезка
+            double center_x = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
+            double center_y = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
+
+            // Генерируем случайный угол с осью абсцисс (в радианах)
+            double angle = (double)rand() / RAND_MAX * 2 * M_PI; // от 0 до 2pi
+
+            // Вычисляем координаты концов отрезка(тригонометрия)
+            double half_length = segment_length / 2.0;
+            double dx = half_length * cos(angle);       // Проекция на Ox
+            double dy = half_length * sin(angle);       // Проекция на Oy
+
+            sec.begin.x = toCoord(center_x - dx);
+            sec.begin.y = toCoord(center_y - dy);
+            sec.end.x = toCoord(center_x + dx);
+            sec.end.y = toCoord(center_y + dy);
+
+            pushGenerated(sec);
+        }
+    }
+
+    //генерация горизонтальных и вертикальных отрезков заданной длины (дорожки плат, планы этажей)
+    void generate_orthogonal_sections(int n, double segment_length, double min_coord = 0.0, double max_coord = generatorRange()) {
+        clearSections();
+        checkGeneratorSize(segment_length);
+        T step = toCoord(segment_length);
+
+        for (int i = 0; i < n; ++i) {
+            section sec;
+
+            // Начало отрезка, направление - вправо или вверх с равной вероятностью
+            sec.begin.x = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+            sec.begin.y = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+            sec.end = sec.begin;
+            if (rand() % 2) {
+                sec.end.x += step;
+            }
+            else {
+                sec.end.y += step;
+            }
+
+            S.push_back(sec);
+        }
+    }
+
+    // Непосредственный ввод координат концов отрезкА
+    void input_single_section() {
+        section sec;
+        std::cout << "Введите координаты отрезка:\n";
+        std::cout << "Начальная точка (x y): ";
+        std::cin >> sec.begin.x >> sec.begin.y;
+        std::cout << "Конечная точка (x y): ";
+        std::cin >> sec.end.x >> sec.end.y;
+
+        pushSection(sec);
+    }
+
+    //непосредственный ввод координат концов отрезкОВ
+    void input_sections_count(int n) {
+        clearSections();
+
+        for (int i = 0; i < n; ++i) {
+            section sec;
+            std::cout << "Отрезок " << i + 1 << ":\n";
+
+            std::cout << "  Начальная точка (x y): ";
+            std::cin >> sec.begin.x >> sec.begin.y;
+
+            std::cout << "  Конечная точка (x y): ";
+            std::cin >> sec.end.x >> sec.end.y;
+
+            if (sec.begin == sec.end) {
+                throw std::runtime_error("Section is point");
+            }
+            S.push_back(sec);
+        }
+    }
+
+    // Проверка пересечений
+    static bool intersection(section AB, section CD) {
+        // Отрезки с непересекающимися габаритами отсекаются сравнениями, без векторных произведений
+        if (!boxesIntersect(AB, CD)) return false;
+
+        point A = AB.begin;
+        point B = AB.end;
+        point C = CD.begin;
+        point D = CD.end;
+
+        // Как точка лежит относительно отрезка
+        int ABC = side(A, B, C);
+        int ABD = side(A, B, D);
+        int CDA = side(C, D, A);
+        int CDB = side(C, D, B);
+
+        // Лежит ли точка на отрезке (мало лежать на прямой - нужно попасть в сам отрезок)
+        if (ABC == 0 && on_section(A, B, C)) return true;
+        if (ABD == 0 && on_section(A, B, D)) return true;
+        if (CDA == 0 && on_section(C, D, A)) return true;
+        if (CDB == 0 && on_section(C, D, B)) return true;
+
+        if (ABC != ABD && CDA != CDB) return true;
+        return false;
+    }
+
+    // Вид общей точки отрезков: 0 - общих точек нет, CONTACT_PROPER или один из флагов TOUCH_*.
+    // Ненулевой ровно тогда, когда intersection(AB, CD) истинно
+    static int contactKind(section AB, section CD) {
+        if (!boxesIntersect(AB, CD)) return 0;
+
+        point A = AB.begin;
+        point B = AB.end;
+        point C = CD.begin;
+        point D = CD.end;
+
+        int ABC = side(A, B, C);
+        int ABD = side(A, B, D);
+        int CDA = side(C, D, A);
+        int CDB = side(C, D, B);
+
+        if (ABC == 0 && ABD == 0) {
+            if (!on_section(A, B, C) && !on_section(A, B, D) && !on_section(C, D, A) && !on_section(C, D, B)) return 0;
+
+            // Общая часть коллинеарных отрезков - по проекции на ось, вдоль которой AB длиннее
+            bool by_x = std::abs(double(B.x) - A.x) >= std::abs(double(B.y) - A.y);
+            double lo = by_x ? std::max(std::min(A.x, B.x), std::min(C.x, D.x)) : std::max(std::min(A.y, B.y), std::min(C.y, D.y));
+            double hi = by_x ? std::min(std::max(A.x, B.x), std::max(C.x, D.x)) : std::min(std::max(A.y, B.y), std::max(C.y, D.y));
+            return lo < hi ? TOUCH_COLLINEAR_OVERLAP : TOUCH_SHARED_ENDPOINT;
+        }
+
+        // Неколлинеарные отрезки имеют не больше одной общей точки
+        if (ABC == 0 && on_section(A, B, C)) return C == A || C == B ? TOUCH_SHARED_ENDPOINT : TOUCH_ENDPOINT_ON_INTERIOR;
+        if (ABD == 0 && on_section(A, B, D)) return D == A || D == B ? TOUCH_SHARED_ENDPOINT : TOUCH_ENDPOINT_ON_INTERIOR;
+        if (CDA == 0 && on_section(C, D, A)) return TOUCH_ENDPOINT_ON_INTERIOR;
+        if (CDB == 0 && on_section(C, D, B)) return TOUCH_ENDPOINT_ON_INTERIOR;
+
+        return ABC != ABD && CDA != CDB ? CONTACT_PROPER : 0;
+    }
+
+    // Проверка пересечения с учётом политики касаний policy (комбинация флагов TOUCH_*)
+    static bool intersection(section AB, section CD, int policy) {
+        int kind = contactKind(AB, CD);
+        return kind == CONTACT_PROPER || (kind & policy) != 0;
+    }
+
+    // Политика касаний, которую соблюдают все алгоритмы поиска этого набора
+    void setTouchPolicy(int policy) {
+        touch_policy = policy;
+    }
+
+    int touchPolicy() const {
+        return touch_policy;
+    }
+
+    // Число потоков сортировки событий заметающей прямой (0 - по числу ядер). Порядок событий, а значит
+    // и найденные пары, от него не зависят: равные события всегда упорядочены по номеру отрезка
+    void setSortThreads(int threads) {
+        sort_threads = threads;
+    }
+
+    int sortThreads() const {
+        return sort_threads > 0 ? sort_threads : std::max(1, int(std::thread::hardware_concurrency()));
+    }
+
+    // Лежит ли точка C, коллинеарная AB, внутри прямоугольника AB (т е на самом отрезке)
+    static bool on_section(point A, point B, point C) {
+        return std::min(A.x, B.x) <= C.x && C.x <= std::max(A.x, B.x) &&
+            std::min(A.y, B.y) <= C.y && C.y <= std::max(A.y, B.y);
+    }
+
+    static int side(point A, point B, point C) {
+        return side(A, B, C, std::is_integral<T>());
+    }
+
+private:
+    static int side(const point& A, const point& B, const point& C, std::false_type) {
+        // Знак векторного произведения (B-A)*(C-A): фильтр по оценке погрешности, у нуля - точно
+        int det = RobustPredicates::orient(A.x, A.y, B.x, B.y, C.x, C.y);
+
+        if (det > 0) return 1;		//left
+        else if (det < 0) return 2; //right
+        return 0;					//on AB
+    }
+
+    // Целые координаты: разности int32 помещаются в int64, их произведения - в 128 бит, знак точный
+    static int side(const point& A, const point& B, const point& C, std::true_type) {
+        wide_int det = wide_int(int64_t(B.x) - A.x) * (int64_t(C.y) - A.y) -
+            wide_int(int64_t(B.y) - A.y) * (int64_t(C.x) - A.x);
+
+        int sign = wideSign(det);
+        return sign > 0 ? 1 : sign < 0 ? 2 : 0;
+    }
+
+public:
+
+    // Наивный алгоритм поиска пересечения за O(n^2)
+    bool intersectionNaive(section& s1, section& s2) const {
+        bool found = false;
+        reportIntersectionsNaive([&](int i, int j) {
+            s1 = getSection(i);
+            s2 = getSection(j);
+            found = true;
+            return false;
+            });
+        return found;
+    }
+
+    // Доступ к отрезкам по индексам (в порядке добавления, в том числе после reorderSpatially)
+    const section& getSection(int index) const {
+        if (index < 0 || index >= S.size()) {
+            throw std::out_of_range("Invalid section index");
+        }
+        return S[storageIndex(index)];
+    }
+
+    // Замена отрезка. Изменяемой ссылки на отрезок набор не выдаёт: запись через ссылку, сохранённую
+    // до очередного запроса, не сбросила бы SoA-копию и кэш событий, и запрос работал бы по старым данным
+    void setSection(int index, const section& sec) {
+        if (index < 0 || index >= S.size()) {
+            throw std::out_of_range("Invalid section index");
+        }
+        if (sec.begin == sec.end) {
+            throw std::runtime_error("Section is point");
+        }
+        S[storageIndex(index)] = sec;
+        invalidate();
+    }
+
+    // Исходный индекс отрезка, лежащего на позиции pos (позиции - порядок view() и SoA-массивов)
+    int originalIndex(int pos) const {
+        return original.empty() ? pos : original[pos];
+    }
+
+    // Позиция отрезка с исходным индексом index
+    int storageIndex(int index) const {
+        return position.empty() ? index : position[index];
+    }
+
+    // Переупорядочивание отрезков по коду середины на кривой Мортона или Гильберта (по 16 бит на ось
+    // внутри габаритов середин). Отрезки, близкие на плоскости, оказываются рядом и в памяти: проходы
+    // сетки, заметающей прямой и плиток наивного поиска читают соседние строки кэша и страницы.
+    // Коды сортируются поразрядно (RadixSort, threads потоков; 0 - по числу ядер). Внешние индексы
+    // не меняются: sink всех report-функций, allIntersections, getSection и intersectionPoints
+    // по-прежнему работают с индексами в порядке добавления
+    void reorderSpatially(SpaceCurve curve = CURVE_HILBERT, int threads = 0) {
+        int n = S.size();
+        if (n < 2) return;
+        if (threads <= 0) {
+            threads = std::max(1, int(std::thread::hardware_concurrency()));
+        }
+
+        double inf = std::numeric_limits<double>::infinity();
+        double x_min = inf, y_min = inf, x_max = -inf, y_max = -inf;
+        for (const section& sec : S) {
+            double mx = (double(sec.begin.x) + sec.end.x) / 2, my = (double(sec.begin.y) + sec.end.y) / 2;
+            x_min = std::min(x_min, mx);
+            x_max = std::max(x_max, mx);
+            y_min = std::min(y_min, my);
+            y_max = std::max(y_max, my);
+        }
+        double sx = x_max > x_min ? 65535.0 / (x_max - x_min) : 0.0;
+        double sy = y_max > y_min ? 65535.0 / (y_max - y_min) : 0.0;
+
+        std::vector<uint32_t> keys(n);
+        std::vector<int> order(n);
+        for (int i = 0; i < n; ++i) {
+            const section& sec = S[i];
+            uint32_t qx = uint32_t(((double(sec.begin.x) + sec.end.x) / 2 - x_min) * sx);
+            uint32_t qy = uint32_t(((double(sec.begin.y) + sec.end.y) / 2 - y_min) * sy);
+            keys[i] = curve == CURVE_MORTON ? mortonCode(qx, qy) : hilbertCode(qx, qy);
+            order[i] = i;
+        }
+        RadixSort::sortPairs(keys, order, threads);
+
+        std::vector<section> sorted(n);
+        std::vector<int> sorted_original(n);
+        for (int k = 0; k < n; ++k) {
+            sorted[k] = S[order[k]];
+            sorted_original[k] = originalIndex(order[k]);
+        }
+        S.swap(sorted);
+        original.swap(sorted_original);
+        position.resize(n);
+        for (int k = 0; k < n; ++k) {
+            position[original[k]] = k;
+        }
+        invalidate();
+    }
+
+    // Данные заметающей прямой заранее: SoA-копия, отсортированные компактные события и коэффициенты
+    // прямых. Повторные intersectionEffective на неизменном наборе их не пересчитывают; изменение набора
+    // (add_section, генераторы, ввод, setSection, reorderSpatially) сбрасывает кэш.
+    // Как и view(), безопасно при одновременных константных запросах из нескольких потоков
+    void prepare() const {
+        CompactEvent::Buffers<CompactEvent> buffers;
+        prepare(buffers);
+    }
+
+    // То же с буферами сортировки из рабочей памяти
+    void prepare(SweepWorkspaceT<T>& workspace) const {
+        prepare(workspace.sort_buffers);
+    }
+
+private:
+    void prepare(CompactEvent::Buffers<CompactEvent>& buffers) const {
+        view();
+        if (cache.events_valid.load(std::memory_order_acquire)) return;
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        if (!cache.events_valid.load(std::memory_order_relaxed)) {
+            prepareCompactEvents(sorted_events, buffers);
+            prepareLines(sweep_lines);
+            cache.events_valid.store(true, std::memory_order_release);
+        }
+    }
+
+public:
+    // Координаты отрезков по отдельным выровненным массивам. Первое обращение после изменения набора
+    // строит копию за O(n) под мьютексом кэша (см. CacheState); параллельные режимы всё равно вызывают
+    // view() до запуска потоков, чтобы не ждать друг друга
+    SectionView view() const {
+        if (!cache.arrays_valid.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            if (!cache.arrays_valid.load(std::memory_order_relaxed)) {
+                arrays.assign(S);
+                cache.arrays_valid.store(true, std::memory_order_release);
+            }
+        }
+        return arrays.view();
+    }
+
+public:
+    // Вычисляет y-координату пересечения отрезка с вертикальной линией x
+    double get_y_at_x(const section& seg, double x) const {
+        //Проверка на вертикальную прямую(т е верхняя и нижняя точка лежат на одном x)
+        if (std::abs(double(seg.end.x) - seg.begin.x) < 1e-9) {
+            // Вертикальный отрезок - возвращаем среднее y
+            return (double(seg.begin.y) + seg.end.y) / 2.0;
+        }
+        // Линейная интерполяция: y = y1 + (y2-y1)*(x-x1)/(x2-x1)
+        return seg.begin.y + (double(seg.end.y) - seg.begin.y) *
+            (x - seg.begin.x) / (double(seg.end.x) - seg.begin.x);
+    }
+    // Коэффициенты прямых всех отрезков для порядка на заметающей прямой (считаются один раз за O(n))
+    void prepareLines(std::vector<LineCoeffs>& lines) const {
+        SectionView v = view();
+        lines.resize(v.n);
+        for (int i = 0; i < v.n; ++i) {
+            lines[i] = LineCoeffs::fromEnds(v.x0[i], v.y0[i], v.x1[i], v.y1[i]);
+        }
+    }
+
+    // Целые концы отрезков для точного порядка на заметающей прямой; для T с плавающей точкой пусто
+    void prepareExactLines(std::vector<ExactLine>& exact) const {
+        prepareExactLines(exact, std::is_integral<T>());
+    }
+
+    // Компактные события всех отрезков в порядке заметающей прямой (как Event::sort): сортируются
+    // 12 байт на событие - ключ и код, а в результате остаются только 4-байтовые коды
+    void prepareCompactEvents(std::vector<CompactEvent>& events) const {
+        CompactEvent::Buffers<CompactEvent> buffers;
+        prepareCompactEvents(events, buffers);
+    }
+
+    void prepareCompactEvents(std::vector<CompactEvent>& events, CompactEvent::Buffers<CompactEvent>& buffers) const {
+        SectionView v = view();
+        events.clear();
+        events.reserve(2 * size_t(v.n));
+        for (int i = 0; i < v.n; ++i) {
+            events.push_back(CompactEvent::left(i));
+        }
+        for (int i = 0; i < v.n; ++i) {
+            events.push_back(CompactEvent::right(i));
+        }
+        CompactEvent::sortByPoint(events, [&](CompactEvent event) { return eventPoint(v, event); }, sortThreads(), buffers);
+    }
+
+    // Точка компактного события - левый или правый (в лексикографическом порядке) конец отрезка
+    static pointT<double> eventPoint(const SectionView& v, CompactEvent event) {
+        int i = event.segment();
+        pointT<double> a{ double(v.x0[i]), double(v.y0[i]) };
+        pointT<double> b{ double(v.x1[i]), double(v.y1[i]) };
+        return (b < a) == event.isLeft() ? b : a;
+    }
+
+private:
+    void prepareExactLines(std::vector<ExactLine>& exact, std::false_type) const {
+        exact.clear();
+    }
+
+    void prepareExactLines(std::vector<ExactLine>& exact, std::true_type) const {
+        SectionView v = view();
+        exact.resize(v.n);
+        for (int i = 0; i < v.n; ++i) {
+            exact[i] = ExactLine::fromEnds(v.x0[i], v.y0[i], v.x1[i], v.y1[i]);
+        }
+    }
+
+public:
+
+    // Эффективный алгоритм поиска пересечения за O(n log n) с использованием AVL-дерева
+    // (для набора из горизонталей и вертикалей - специализированным проходом)
+    bool intersectionEffective(section& s1, section& s2) const {
+        SweepWorkspaceT<T> workspace;
+        return intersectionEffective(s1, s2, workspace);
+    }
+
+    // То же в рабочей памяти workspace: буферы сортировки и узлы дерева статуса берутся из неё
+    bool intersectionEffective(section& s1, section& s2, SweepWorkspaceT<T>& workspace) const {
+        if (S.empty()) return false;
+        if (isOrthogonal()) {
+            return firstOrthogonalIntersection(s1, s2, workspace);
+        }
+    
+        // 1. Компактные события (номер отрезка и флаг конца), упорядоченные лексикографически по точкам,
+        // и коэффициенты прямых для сравнения отрезков на заметающей прямой - из кэша (см. prepare());
+        // точки событий берутся из SoA-массивов
+        prepare(workspace);
+        SectionView v = view();
+        const std::vector<CompactEvent>& events = sorted_events;
+
+        // 2. Обработка событий слева направо
+        return sweepEvents(events, [&](size_t k) { return eventPoint(v, events[k]); }, sweep_lines, s1, s2, workspace);
+    }
+
+    // Версия эффективного алгоритма с предварительно подготовленными событиями(для правильного счёта времени T2: отсортированные события)
+    bool intersectionEffectiveWithPreparedEvents(section& s1, section& s2, const std::vector<Event>& events) {
+        if (S.empty()) return false;
+
+        std::vector<LineCoeffs> lines;
+        prepareLines(lines);
+        return sweepEvents(events, lines, s1, s2);
+    }
+
+    // Версия с предварительно подготовленными событиями и коэффициентами прямых (только работа с AVL-деревом)
+    bool intersectionEffectiveWithPreparedEvents(section& s1, section& s2, const std::vector<Event>& events,
+        const std::vector<LineCoeffs>& lines) const {
+        if (S.empty()) return false;
+        return sweepEvents(events, lines, s1, s2);
+    }
+
+    bool hasIntersectionEffective() {
+        section s1, s2;
+        return intersectionEffective(s1, s2);
+    }
+
+    // Параллельный поиск пересечения: ось x делится на вертикальные полосы с примерно равным числом
+    // концов отрезков (границы - квантили выборки), в каждой полосе свой проход Шамоса–Хоуи
+    // по отрезкам, обрезанным полосой. Полосы замкнуты, поэтому точка пересечения на границе видна
+    // обеим; проверяются исходные отрезки. Первая нашедшая пересечение полоса отменяет остальные.
+    // Какая из пар будет найдена, зависит от расписания потоков; ответ да/нет - нет.
+    // Отрезки раскладываются по полосам одним проходом до запуска потоков, и полоса перебирает только
+    // свои. Отрезок, проходящий несколько полос, участвует в каждой - режим рассчитан на короткие отрезки
+    bool intersectionParallel(section& s1, section& s2, int threads = 0) const {
+        int n = S.size();
+        if (threads <= 0) {
+            threads = std::max(1, int(std::thread::hardware_concurrency()));
+        }
+        if (threads == 1 || n < 2 * threads) {
+            return intersectionEffective(s1, s2);
+        }
+
+        // 1. Границы полос по квантилям выборки концов отрезков
+        std::vector<double> sample;
+        size_t step = std::max<size_t>(1, 2 * S.size() / (64 * threads));
+        for (size_t k = 0; k < 2 * S.size(); k += step) {
+            const section& sec = S[k / 2];
+            sample.push_back(k % 2 ? std::max(sec.begin.x, sec.end.x) : std::min(sec.begin.x, sec.end.x));
+        }
+        std::sort(sample.begin(), sample.end());
+        std::vector<double> bounds{ -std::numeric_limits<double>::infinity() };
+        for (int t = 1; t < threads; ++t) {
+            double x = sample[t * sample.size() / threads];
+            if (x > bounds.back()) bounds.push_back(x);
+        }
+        bounds.push_back(std::numeric_limits<double>::infinity());
+
+        // SoA-копия строится до запуска потоков, дальше они её только читают
+        SectionView v = view();
+        std::vector<LineCoeffs> lines;
+        prepareLines(lines);
+
+        // 2. Отрезки по полосам в CSR-виде: полосы t, для которых [bounds[t], bounds[t + 1]] задевает
+        // x-проекцию отрезка, - непрерывный диапазон, его концы находятся двоичным поиском
+        int slabs = int(bounds.size()) - 1;
+        std::vector<int> first_slab(n), last_slab(n);
+        std::vector<int> slab_start(slabs + 1, 0);
+        for (int i = 0; i < n; ++i) {
+            double x_min = std::min(v.x0[i], v.x1[i]);
+            double x_max = std::max(v.x0[i], v.x1[i]);
+            first_slab[i] = int(std::lower_bound(bounds.begin() + 1, bounds.end(), x_min) - bounds.begin()) - 1;
+            last_slab[i] = int(std::upper_bound(bounds.begin(), bounds.end() - 1, x_max) - bounds.begin()) - 1;
+            for (int t = first_slab[i]; t <= last_slab[i]; ++t) {
+                slab_start[t + 1]++;
+            }
+        }
+        for (int t = 0; t < slabs; ++t) {
+            slab_start[t + 1] += slab_start[t];
+        }
+        std::vector<int> slab_items(slab_start.back());
+        std::vector<int> fill(slab_start.begin(), slab_start.end() - 1);
+        for (int i = 0; i < n; ++i) {
+            for (int t = first_slab[i]; t <= last_slab[i]; ++t) {
+                slab_items[fill[t]++] = i;
+            }
+        }
+
+        // 3. Проходы по полосам
+        std::atomic<bool> cancel(false);
+        std::mutex result_mutex;
+        bool found = false;
+
+        auto slab = [&](int t) {
+            double a = bounds[t];
+            double b = bounds[t + 1];
+
+            std::vector<Event> events;
+            events.reserve(2 * (slab_start[t + 1] - slab_start[t]));
+            for (int k = slab_start[t]; k < slab_start[t + 1]; ++k) {
+                int i = slab_items[k];
+                pointT<double> left{ double(v.x0[i]), double(v.y0[i]) };
+                pointT<double> right{ double(v.x1[i]), double(v.y1[i]) };
+                if (right < left) {
+                    std::swap(left, right);
+                }
+                // Наклонный отрезок, лишь касающийся границы, целиком лежит в соседней полосе
+                if ((right.x == a || left.x == b) && left.x != right.x) continue;
+
+                // Точный порядок для целых координат требует событий в целых точках, поэтому такой
+                // отрезок обрезается до ближайших к границам полосы целых точек на нём самом
+                if (std::is_integral<T>::value) {
+                    clipToLattice(left, right, a, b);
+                }
+                else {
+                    if (left.x < a) left = { a, lines[i].y_at(a, 0) };
+                    if (right.x > b) right = { b, lines[i].y_at(b, 0) };
+                }
+                events.push_back({ left, i, true });
+                events.push_back({ right, i, false });
+            }
+            Event::sort(events);
+
+            section r1, r2;
+            if (sweepEvents(events, lines, r1, r2, &cancel)) {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                if (!found) {
+                    s1 = r1;
+                    s2 = r2;
+                    found = true;
+                }
+                cancel = true;
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (int t = 1; t < slabs; ++t) {
+            workers.emplace_back(slab, t);
+        }
+        slab(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        return found;
+    }
+
+private:
+    // Отрезок с целыми концами left < right, обрезанный полосой [a, b] без выхода из целых точек:
+    // целые точки отрезка идут с шагом (dx, dy) / gcd(dx, dy), и концы сдвигаются к последним таким
+    // точкам перед границами. Часть отрезка внутри полосы при этом сохраняется целиком
+    static void clipToLattice(pointT<double>& left, pointT<double>& right, double a, double b) {
+        int64_t dx = int64_t(right.x) - int64_t(left.x);
+        int64_t dy = int64_t(right.y) - int64_t(left.y);
+        if (dx == 0) return;
+        int64_t g = dx;
+        for (int64_t r = dy < 0 ? -dy : dy; r != 0;) {
+            int64_t next = g % r;
+            g = r;
+            r = next;
+        }
+        double step_x = double(dx / g);
+        double step_y = double(dy / g);
+        if (left.x < a) {
+            double k = std::floor((a - left.x) / step_x);
+            left = { left.x + k * step_x, left.y + k * step_y };
+        }
+        if (right.x > b) {
+            double k = std::floor((right.x - b) / step_x);
+            right = { right.x - k * step_x, right.y - k * step_y };
+        }
+    }
+
+public:
+    // Параллельный перебор пар. Треугольник i < j режется на квадратные плитки по 1024 отрезка -
+    // SoA-полосы обеих сторон плитки помещаются в L2; потоки разбирают плитки по порядку строк.
+    // Лучшая найденная пара хранится как ключ i * n + j: плитки и строки, которые не могут дать
+    // ключ меньше, пропускаются, поэтому после находки потоки останавливаются, доработав свою строку плитки.
+    // Ответ - лексикографически первая по позициям в S пара, та же, что у intersectionNaive, при любом числе потоков
+    bool intersectionNaiveParallel(section& s1, section& s2, int threads = 0) const {
+        const int tile = 1024;
+        int n = S.size();
+        if (threads <= 0) {
+            threads = std::max(1, int(std::thread::hardware_concurrency()));
+        }
+        if (threads == 1 || n < 2 * tile) {
+            return intersectionNaive(s1, s2);
+        }
+
+        // Плитки (строка, столбец) над диагональю; в таком порядке их наименьшие ключи возрастают
+        SectionView v = view();
+        int tiles = (n + tile - 1) / tile;
+        std::vector<std::pair<int, int>> order;
+        for (int r = 0; r < tiles; ++r) {
+            for (int c = r; c < tiles; ++c) {
+                order.push_back({ r, c });
+            }
+        }
+
+        const long long none = std::numeric_limits<long long>::max();
+        std::atomic<size_t> next(0);
+        std::atomic<long long> best(none);
+
+        auto worker = [&]() {
+            for (size_t t; (t = next++) < order.size(); ) {
+                int i0 = order[t].first * tile;
+                int j0 = order[t].second * tile;
+                int i1 = std::min(i0 + tile, n);
+                int j1 = std::min(j0 + tile, n);
+                if ((long long)i0 * n + j0 >= best.load(std::memory_order_relaxed)) return;
+
+                for (int i = i0; i < i1; ++i) {
+                    int j_begin = std::max(j0, i + 1);
+                    if ((long long)i * n + j_begin >= best.load(std::memory_order_relaxed)) break;
+                    if (j_begin >= j1) continue;
+
+                    section current = v[i];
+                    BatchBlockT<T> row = v.block(j_begin, j1 - j_begin);
+                    uint32_t mask;
+                    int hit = -1;
+                    for (int k = 0; hit < 0 && (k = BatchKernel::scan(current.begin.x, current.begin.y, current.end.x, current.end.y, row, k, mask)) < row.count;
+                        k += BatchKernel::BLOCK) {
+                        for (int j = j_begin + k; mask != 0; ++j, mask >>= 1) {
+                            if ((mask & 1) && intersection(current, v[j], touch_policy)) {
+                                hit = j;
+                                break;
+                            }
+                        }
+                    }
+                    if (hit < 0) continue;
+
+                    // Остальные строки плитки дают только большие ключи
+                    long long key = (long long)i * n + hit;
+                    long long current_best = best.load();
+                    while (key < current_best && !best.compare_exchange_weak(current_best, key)) {}
+                    break;
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (int t = 1; t < threads; ++t) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& w : workers) {
+            w.join();
+        }
+
+        if (best == none) return false;
+        s1 = S[best / n];
+        s2 = S[best % n];
+        return true;
+    }
+
+private:
+    // Погрешность сравнения y на заметающей прямой, соразмерная координатам
+    double sweepEps() const {
+        double scale = 1.0;
+        SectionView v = view();
+        for (int i = 0; i < v.n; ++i) {
+            scale = std::max<double>(scale, std::max(std::max(std::abs(v.x0[i]), std::abs(v.y0[i])),
+                std::max(std::abs(v.x1[i]), std::abs(v.y1[i]))));
+        }
+        return 1e-9 * scale;
+    }
+
+    // Проход заметающей прямой по отсортированным событиям до первого пересечения (Шамос–Хоуи)
+    // События в одной точке обрабатываются группой: сначала удаляются заканчивающиеся в ней отрезки,
+    // затем вставляются начинающиеся. Поэтому допустимое политикой касание концами не оставляет
+    // в дереве отрезки, которые сравнивались бы то в порядке "до" точки, то "после" неё
+    // cancel - флаг отмены от параллельных проходов: проверяется раз в 1024 группы событий
+    bool sweepEvents(const std::vector<Event>& events, const std::vector<LineCoeffs>& lines,
+        section& s1, section& s2, const std::atomic<bool>* cancel = nullptr) const {
+        return sweepEvents(events, [&](size_t k) { return events[k].p; }, lines, s1, s2, cancel);
+    }
+
+    // То же для событий любого вида (Event, CompactEvent): point_of(k) - точка k-го события
+    template <typename Events, typename PointOf>
+    bool sweepEvents(const Events& events, PointOf point_of, const std::vector<LineCoeffs>& lines,
+        section& s1, section& s2, const std::atomic<bool>* cancel = nullptr) const {
+        SweepWorkspaceT<T> workspace;
+        return sweepEvents(events, point_of, lines, s1, s2, workspace, cancel);
+    }
+
+    // То же в рабочей памяти workspace (статус, целые концы, буфер проходящих через точку отрезков)
+    template <typename Events, typename PointOf>
+    bool sweepEvents(const Events& events, PointOf point_of, const std::vector<LineCoeffs>& lines,
+        section& s1, section& s2, SweepWorkspaceT<T>& workspace, const std::atomic<bool>* cancel = nullptr) const {
+        // Статус: активные отрезки, упорядоченные по y на текущей заметающей прямой
+        // (для целых координат - точно, по целым концам)
+        std::vector<ExactLine>& exact = workspace.exact;
+        prepareExactLines(exact);
+        SweepStatus& active_segments = workspace.status;
+        active_segments.reset(lines, sweepEps(), exact.empty() ? nullptr : exact.data());
+        std::vector<int>& through = workspace.through;
+        size_t groups = 0;
+
+        for (size_t i = 0; i < events.size();) {
+            if (cancel && (++groups & 1023) == 0 && cancel->load(std::memory_order_relaxed)) {
+                return false;
+            }
+            pointT<double> p = point_of(i);
+            size_t end = i + 1;
+            while (end < events.size() && point_of(end) == p) ++end;
+            active_segments.moveTo(p.x, p.y);
+
+            // Общий конец у отрезков группы: проверяем напрямую, только если политика считает его пересечением
+            if (touch_policy & TOUCH_SHARED_ENDPOINT) {
+                for (size_t a = i; a < end; ++a) {
+                    for (size_t b = a + 1; b < end; ++b) {
+                        const section& first = S[events[a].segment()];
+                        const section& second = S[events[b].segment()];
+                        if (intersection(first, second, touch_policy)) {
+                            s1 = first;
+                            s2 = second;
+                            return true;
+                        }
+                    }
+                }
+            }
+
+            // Отрезки, проходящие через точку, проверяем с концами в ней напрямую: при разрешённых
+            // касаниях и наложениях соседство в дереве не гарантирует, что такая пара окажется рядом
+            if (touch_policy != TOUCH_ALL) {
+                through.clear();
+                active_segments.through(through);
+                for (size_t k = i; k < end; ++k) {
+                    const section& current_seg = S[events[k].segment()];
+                    for (int id : through) {
+                        if (id != events[k].segment() && intersection(S[id], current_seg, touch_policy)) {
+                            s1 = S[id];
+                            s2 = current_seg;
+                            return true;
+                        }
+                    }
+                }
+            }
+
+            // Перед удалением проверяем пару соседей, которые станут смежными
+            for (size_t k = i; k < end; ++k) {
+                if (events[k].isLeft()) continue;
+                int seg_id = events[k].segment();
+
+                int pred_id, succ_id;
+                bool has_pred = active_segments.belowEnding(seg_id, pred_id);
+                bool has_succ = active_segments.aboveEnding(seg_id, succ_id);
+                if (has_pred && has_succ && intersection(S[pred_id], S[succ_id], touch_policy)) {
+                    s1 = S[pred_id];
+                    s2 = S[succ_id];
+                    return true;
+                }
+
+                active_segments.erase(seg_id);
+            }
+
+            // Вставка отрезка и проверка его соседей снизу и сверху - O(log n)
+            for (size_t k = i; k < end; ++k) {
+                if (!events[k].isLeft()) continue;
+                int seg_id = events[k].segment();
+                const section& current_seg = S[seg_id];
+                active_segments.insert(seg_id);
+
+                int pred_id, succ_id;
+                if (active_segments.below(seg_id, pred_id) && intersection(S[pred_id], current_seg, touch_policy)) {
+                    s1 = S[pred_id];
+                    s2 = current_seg;
+                    return true;
+                }
+                if (active_segments.above(seg_id, succ_id) && intersection(S[succ_id], current_seg, touch_policy)) {
+                    s1 = S[succ_id];
+                    s2 = current_seg;
+                    return true;
+                }
+            }
+
+            i = end;
+        }
+
+        return false;
+    }
+
+    bool collinear(const section& AB, const section& CD) const {
+        return side(AB.begin, AB.end, CD.begin) == 0 && side(AB.begin, AB.end, CD.end) == 0;
+    }
+
+    // Точка пересечения прямых, на которых лежат непараллельные отрезки: A + t*(B-A)
+    pointT<double> crossingPoint(const section& AB, const section& CD) const {
+        pointT<double> A{ double(AB.begin.x), double(AB.begin.y) };
+        pointT<double> B{ double(AB.end.x), double(AB.end.y) };
+        pointT<double> C{ double(CD.begin.x), double(CD.begin.y) };
+        pointT<double> D{ double(CD.end.x), double(CD.end.y) };
+
+        double rx = B.x - A.x, ry = B.y - A.y;
+        double sx = D.x - C.x, sy = D.y - C.y;
+        double t = ((C.x - A.x) * sy - (C.y - A.y) * sx) / (rx * sy - ry * sx);
+        return { A.x + t * rx, A.y + t * ry };
+    }
+
+    // Самая левая x общей части двух пересекающихся отрезков: для касания - точный x конца,
+    // для коллинеарных - начало наложения
+    double firstCommonX(const section& AB, const section& CD) const {
+        if (collinear(AB, CD)) {
+            return std::max(std::min(AB.begin.x, AB.end.x), std::min(CD.begin.x, CD.end.x));
+        }
+        if (side(AB.begin, AB.end, CD.begin) == 0 && on_section(AB.begin, AB.end, CD.begin)) return CD.begin.x;
+        if (side(AB.begin, AB.end, CD.end) == 0 && on_section(AB.begin, AB.end, CD.end)) return CD.end.x;
+        if (side(CD.begin, CD.end, AB.begin) == 0 && on_section(CD.begin, CD.end, AB.begin)) return AB.begin.x;
+        if (side(CD.begin, CD.end, AB.end) == 0 && on_section(CD.begin, CD.end, AB.end)) return AB.end.x;
+        return crossingPoint(AB, CD).x;
+    }
+
+    // Если отрезки a и b пересекаются во внутренней точке обоих после текущего события,
+    // добавляем эту точку в очередь пересечений
+    void findCrossing(int a, int b, pointT<double> p, std::set<pointT<double>>& crossings) const {
+        point A = S[a].begin;
+        point B = S[a].end;
+        point C = S[b].begin;
+        point D = S[b].end;
+
+        int ABC = side(A, B, C);
+        int ABD = side(A, B, D);
+        int CDA = side(C, D, A);
+        int CDB = side(C, D, B);
+        if (ABC == 0 || ABD == 0 || CDA == 0 || CDB == 0) return;  // касания обрабатываются в событиях-концах
+        if (ABC == ABD || CDA == CDB) return;
+
+        pointT<double> q = crossingPoint(S[a], S[b]);
+
+        // Совпадение с p в пределах погрешности не повод отбрасывать точку: эти отрезки
+        // не прошли через текущее событие, иначе не оказались бы соседями "снаружи" него
+        if (p < q) {
+            crossings.insert(q);
+        }
+    }
+
+    // Пары коллинеарных горизонталей (horizontal) или вертикалей с общими точками:
+    // сортировка по прямой и началу интервала, активные интервалы - куча по концу.
+    // Возвращает false, если report попросил остановиться
+    template <typename Report>
+    bool reportCollinear(std::vector<int>& ids, bool horizontal, Report& report, std::vector<int>& active) const {
+        auto line = [&](int id) { return horizontal ? S[id].begin.y : S[id].begin.x; };
+        auto lo = [&](int id) { return horizontal ? std::min(S[id].begin.x, S[id].end.x) : std::min(S[id].begin.y, S[id].end.y); };
+        auto hi = [&](int id) { return horizontal ? std::max(S[id].begin.x, S[id].end.x) : std::max(S[id].begin.y, S[id].end.y); };
+
+        std::sort(ids.begin(), ids.end(), [&](int a, int b) {
+            return line(a) < line(b) || (line(a) == line(b) && lo(a) < lo(b));
+            });
+
+        active.clear();
+        auto ends_first = [&](int a, int b) { return hi(a) > hi(b); };
+        for (size_t k = 0; k < ids.size(); ++k) {
+            int id = ids[k];
+            if (k > 0 && line(ids[k - 1]) != line(id)) {
+                active.clear();
+            }
+            while (!active.empty() && hi(active.front()) < lo(id)) {
+                std::pop_heap(active.begin(), active.end(), ends_first);
+                active.pop_back();
+            }
+            for (int other : active) {
+                if (!report(other, id)) return false;
+            }
+            active.push_back(id);
+            std::push_heap(active.begin(), active.end(), ends_first);
+        }
+        return true;
+    }
+
+    // Алгоритм Бентли–Оттмана: проверяются и передаются в sink только пары, для которых wanted(i, j) истинно;
+    // остальные пересечения всё равно обрабатываются как события, чтобы порядок на прямой оставался верным
+    template <typename Filter, typename Sink>
+    void sweepIntersections(Filter wanted, Sink sink) const {
+        int n = S.size();
+        if (n < 2) return;
+
+        // 1. События-концы отрезков, отсортированные лексикографически
+        SectionView v = view();
+        std::vector<Event> events;
+        events.reserve(2 * n);
+        for (int i = 0; i < n; ++i) {
+            pointT<double> left{ double(v.x0[i]), double(v.y0[i]) };
+            pointT<double> right{ double(v.x1[i]), double(v.y1[i]) };
+            if (right < left) {
+                std::swap(left, right);
+            }
+            events.push_back({ left, i, true });
+            events.push_back({ right, i, false });
+        }
+        Event::sort(events, sortThreads());
+
+        // 2. Динамическая очередь событий-пересечений (в том же лексикографическом порядке)
+        std::set<pointT<double>> crossings;
+
+        // 3. Статус: активные отрезки, упорядоченные на текущей заметающей прямой
+        std::vector<LineCoeffs> lines;
+        prepareLines(lines);
+        std::vector<int> rank(n, 0);
+        SweepStatus active_segments(lines, sweepEps());
+        active_segments.setRank(rank.data());
+        const SweepLine& line = active_segments.position();
+
+        // Роль отрезка в текущем событии: 1 - начинается в p, 2 - заканчивается, 3 - проходит через p
+        std::vector<char> role(n, 0);
+        std::vector<int> U, L, C, group;
+        size_t i = 0;
+
+        while (i < events.size() || !crossings.empty()) {
+            // Ближайшее событие: конец отрезка или точка пересечения
+            pointT<double> p = (crossings.empty() || (i < events.size() && !(*crossings.begin() < events[i].p)))
+                ? events[i].p : *crossings.begin();
+            active_segments.moveTo(p.x, p.y);
+
+            U.clear();
+            L.clear();
+            C.clear();
+            // Совпадающие с p (в пределах погрешности) события могут идти не подряд:
+            // между ними в лексикографическом порядке встречаются точки с тем же x и другим y
+            for (size_t j = i; j < events.size() && events[j].p.x <= p.x + line.eps; ++j) {
+                if (!line.near(events[j].p.x, events[j].p.y)) continue;
+                std::rotate(events.begin() + i, events.begin() + j, events.begin() + j + 1);
+                int id = events[i].segment_index;
+                if (events[i].is_left) {
+                    U.push_back(id);
+                    role[id] = 1;
+                }
+                else if (role[id] == 1) {
+                    // Отрезок короче погрешности: начинается и заканчивается в p, в дерево не попадает
+                    U.erase(std::find(U.begin(), U.end(), id));
+                    L.push_back(id);
+                    role[id] = 4;
+                }
+                else {
+                    L.push_back(id);
+                    role[id] = 2;
+                }
+                ++i;
+            }
+            for (auto it = crossings.begin(); it != crossings.end() && it->x <= p.x + line.eps;) {
+                it = line.near(it->x, it->y) ? crossings.erase(it) : std::next(it);
+            }
+
+            // Активные отрезки, проходящие через p
+            group.clear();
+            active_segments.through(group);
+            for (size_t k = 0; k < group.size(); ++k) {
+                int id = group[k];
+                rank[id] = k;
+                if (role[id] == 0) {
+                    C.push_back(id);
+                    role[id] = 3;
+                }
+            }
+
+            // Все пары среди отрезков, имеющих общую точку p
+            group.clear();
+            group.insert(group.end(), U.begin(), U.end());
+            group.insert(group.end(), L.begin(), L.end());
+            group.insert(group.end(), C.begin(), C.end());
+            bool stop = false;
+            for (size_t a = 0; a < group.size() && !stop; ++a) {
+                for (size_t b = a + 1; b < group.size() && !stop; ++b) {
+                    int s1 = group[a];
+                    int s2 = group[b];
+                    if (!wanted(s1, s2)) continue;
+                    // Наложение коллинеарных отрезков уже учтено там, где оно началось
+                    if (role[s1] != 1 && role[s2] != 1 && collinear(S[s1], S[s2])) continue;
+                    // Два отрезка, проходящих через p, пересекаются здесь, только если меняются местами:
+                    // иначе они пересеклись в соседнем (в пределах погрешности) событии и уже учтены
+                    if (role[s1] == 3 && role[s2] == 3 && (rank[s1] < rank[s2]) == line.less(s1, s2)) continue;
+                    if (intersection(S[s1], S[s2], touch_policy)) {
+                        stop = !reportOriginal(sink, s1, s2);
+                    }
+                }
+            }
+            for (int id : group) {
+                role[id] = 0;
+            }
+            if (stop) return;
+
+            // Удаляем заканчивающиеся и проходящие через p (порядок "до" p) ...
+            for (int id : L) active_segments.erase(id);
+            for (int id : C) active_segments.erase(id);
+
+            // ... и вставляем начинающиеся и проходящие через p (порядок "после" p)
+            for (int id : U) active_segments.insert(id);
+            for (int id : C) active_segments.insert(id);
+
+            // Проверяем новые пары соседей
+            int below, above;
+            if (U.empty() && C.empty()) {
+                if (active_segments.below(SweepLine::PROBE, below) && active_segments.above(SweepLine::PROBE, above)) {
+                    findCrossing(below, above, p, crossings);
+                }
+            }
+            else {
+                group.assign(U.begin(), U.end());
+                group.insert(group.end(), C.begin(), C.end());
+                int lowest = *std::min_element(group.begin(), group.end(), SweepOrder{ &line });
+                int highest = *std::max_element(group.begin(), group.end(), SweepOrder{ &line });
+                if (active_segments.below(lowest, below)) {
+                    findCrossing(below, lowest, p, crossings);
+                }
+                if (active_segments.above(highest, above)) {
+                    findCrossing(highest, above, p, crossings);
+                }
+            }
+        }
+    }
+
+public:
+    // Все пары пересекающихся отрезков: алгоритм Бентли–Оттмана за O((n+k) log n)
+    // sink(i, j) вызывается один раз для каждой пары индексов i < j; если sink вернул false, поиск прекращается
+    template <typename Sink>
+    void reportIntersections(Sink sink) const {
+        if (isOrthogonal()) {
+            reportOrthogonalIntersections(sink);
+            return;
+        }
+        sweepIntersections([](int, int) { return true; }, sink);
+    }
+
+    // Все пары пересекающихся отрезков в виде пар индексов (i < j)
+    std::vector<std::pair<int, int>> allIntersections() const {
+        std::vector<std::pair<int, int>> pairs;
+        reportIntersections([&](int i, int j) {
+            pairs.push_back({ i, j });
+            return true;
+            });
+        return pairs;
+    }
+
+    // Общие части пар отрезков pairs[0..count) в out[0..count); пары - пересекающиеся, как их выдают
+    // reportIntersections и allIntersections (для остальных результат не определён). Координаты пар
+    // собираются блоками по 64 в отдельные массивы, и точка пересечения прямых считается для всего блока
+    // одним проходом без ветвлений, который компилятор векторизует; отдельно пересчитываются только
+    // почти параллельные пары: у коллинеарных - отрезок наложения, у касающихся - точный конец.
+    // threads > 1 делит пары между потоками поровну (0 - по числу ядер)
+    void intersectionPoints(const std::pair<int, int>* pairs, size_t count, Crossing* out, int threads = 1) const {
+        SectionView v = view();   // до запуска потоков, дальше они только читают
+        if (threads <= 0) {
+            threads = std::max(1, int(std::thread::hardware_concurrency()));
+        }
+        size_t part = (count + threads - 1) / threads;
+        if (threads == 1 || part < 1024) {
+            crossingRange(v, pairs, 0, count, out);
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        for (size_t from = part; from < count; from += part) {
+            workers.emplace_back([&, from] { crossingRange(v, pairs, from, std::min(count, from + part), out); });
+        }
+        crossingRange(v, pairs, 0, part, out);
+        for (std::thread& w : workers) {
+            w.join();
+        }
+    }
+
+    std::vector<Crossing> intersectionPoints(const std::vector<std::pair<int, int>>& pairs, int threads = 1) const {
+        std::vector<Crossing> out(pairs.size());
+        intersectionPoints(pairs.data(), pairs.size(), out.data(), threads);
+        return out;
+    }
+
+    // Общая часть одной пары пересекающихся отрезков
+    Crossing crossingOf(const section& AB, const section& CD) const {
+        pointT<double> A{ double(AB.begin.x), double(AB.begin.y) };
+        pointT<double> B{ double(AB.end.x), double(AB.end.y) };
+        pointT<double> C{ double(CD.begin.x), double(CD.begin.y) };
+        pointT<double> D{ double(CD.end.x), double(CD.end.y) };
+
+        if (collinear(AB, CD)) {
+            // Наложение - по проекции на ось, вдоль которой AB длиннее
+            bool by_x = std::abs(B.x - A.x) >= std::abs(B.y - A.y);
+            auto key = [by_x](const pointT<double>& p) { return by_x ? p.x : p.y; };
+            if (key(B) < key(A)) std::swap(A, B);
+            if (key(D) < key(C)) std::swap(C, D);
+            return { key(A) < key(C) ? C : A, key(B) < key(D) ? B : D };
+        }
+        if (side(AB.begin, AB.end, CD.begin) == 0 && on_section(AB.begin, AB.end, CD.begin)) return { C, C };
+        if (side(AB.begin, AB.end, CD.end) == 0 && on_section(AB.begin, AB.end, CD.end)) return { D, D };
+        if (side(CD.begin, CD.end, AB.begin) == 0 && on_section(CD.begin, CD.end, AB.begin)) return { A, A };
+        if (side(CD.begin, CD.end, AB.end) == 0 && on_section(CD.begin, CD.end, AB.end)) return { B, B };
+        pointT<double> q = crossingPoint(AB, CD);
+        return { q, q };
+    }
+
+private:
+    // Чередование битов: x - в чётных разрядах, y - в нечётных
+    static uint32_t mortonCode(uint32_t x, uint32_t y) {
+        auto spread = [](uint32_t v) {
+            v = (v | (v << 8)) & 0x00FF00FFu;
+            v = (v | (v << 4)) & 0x0F0F0F0Fu;
+            v = (v | (v << 2)) & 0x33333333u;
+            v = (v | (v << 1)) & 0x55555555u;
+            return v;
+        };
+        return spread(x) | (spread(y) << 1);
+    }
+
+    // Номер клетки (x, y) сетки 2^16 x 2^16 на кривой Гильберта
+    static uint32_t hilbertCode(uint32_t x, uint32_t y) {
+        const uint32_t side = 1u << 16;
+        uint32_t d = 0;
+        for (uint32_t s = side / 2; s > 0; s /= 2) {
+            uint32_t rx = (x & s) ? 1 : 0;
+            uint32_t ry = (y & s) ? 1 : 0;
+            d += s * s * ((3 * rx) ^ ry);
+            // Поворот четверти, чтобы следующий уровень шёл в той же ориентации
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = side - 1 - x;
+                    y = side - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return d;
+    }
+
+    // Пары [from, to) для intersectionPoints. Хвост последнего блока дополняется первой парой блока,
+    // чтобы проход по блоку всегда имел одну длину
+    void crossingRange(const SectionView& v, const std::pair<int, int>* pairs, size_t from, size_t to, Crossing* out) const {
+        const int lanes = 64;
+        double ax[lanes], ay[lanes], bx[lanes], by[lanes], cx[lanes], cy[lanes], dx[lanes], dy[lanes];
+        double px[lanes], py[lanes], slack[lanes];
+
+        for (size_t base = from; base < to; base += lanes) {
+            int m = int(std::min<size_t>(lanes, to - base));
+            for (int k = 0; k < lanes; ++k) {
+                const std::pair<int, int>& p = pairs[base + (k < m ? k : 0)];
+                int a = storageIndex(p.first), c = storageIndex(p.second);
+                ax[k] = v.x0[a];
+                ay[k] = v.y0[a];
+                bx[k] = v.x1[a];
+                by[k] = v.y1[a];
+                cx[k] = v.x0[c];
+                cy[k] = v.y0[c];
+                dx[k] = v.x1[c];
+                dy[k] = v.y1[c];
+            }
+
+            // A + t*(B-A). Ни ветвлений, ни смешения типов: иначе при -O2 цикл не векторизуется,
+            // поэтому признак почти нулевого знаменателя - тоже double (slack <= 0)
+            for (int k = 0; k < lanes; ++k) {
+                double rx = bx[k] - ax[k], ry = by[k] - ay[k];
+                double sx = dx[k] - cx[k], sy = dy[k] - cy[k];
+                double l = rx * sy, r = ry * sx;
+                double denom = l - r;
+                double t = ((cx[k] - ax[k]) * sy - (cy[k] - ay[k]) * sx) / denom;
+                px[k] = ax[k] + t * rx;
+                py[k] = ay[k] + t * ry;
+                slack[k] = std::abs(denom) - 1e-12 * (std::abs(l) + std::abs(r));
+            }
+
+            for (int k = 0; k < m; ++k) {
+                const std::pair<int, int>& p = pairs[base + k];
+                if (!(slack[k] > 0)) {
+                    out[base + k] = crossingOf(v[storageIndex(p.first)], v[storageIndex(p.second)]);
+                }
+                else {
+                    out[base + k].begin = out[base + k].end = { px[k], py[k] };
+                }
+            }
+        }
+    }
+
+public:
+    // Первая найденная пара специализированным алгоритмом для горизонталей и вертикалей
+    bool firstOrthogonalIntersection(section& s1, section& s2) const {
+        SweepWorkspaceT<T> workspace;
+        return firstOrthogonalIntersection(s1, s2, workspace);
+    }
+
+    bool firstOrthogonalIntersection(section& s1, section& s2, SweepWorkspaceT<T>& workspace) const {
+        bool found = false;
+        reportOrthogonalIntersections([&](int i, int j) {
+            s1 = getSection(i);
+            s2 = getSection(j);
+            found = true;
+            return false;
+            }, workspace);
+        return found;
+    }
+
+    // Все ли отрезки горизонтальны или вертикальны
+    bool isOrthogonal() const {
+        for (const section& sec : S) {
+            if (sec.begin.x != sec.end.x && sec.begin.y != sec.end.y) return false;
+        }
+        return true;
+    }
+
+    // Пары пересекающихся отрезков набора из одних горизонталей и вертикалей за O(n log n + k):
+    // коллинеарные пары - перебор перекрывающихся интервалов на каждой прямой, пары
+    // горизонталь-вертикаль - проход по x, где вертикаль запрашивает активные горизонтали
+    // с y из своего диапазона. Ключи - целочисленные ранги y, активные горизонтали хранятся
+    // списками по рангам в массивах, непустые ранги - в RankSet.
+    // Перебираются все пары с общей точкой; не учитываемые политикой касания отбрасываются при выдаче
+    template <typename Sink>
+    void reportOrthogonalIntersections(Sink sink) const {
+        SweepWorkspaceT<T> workspace;
+        reportOrthogonalIntersections(sink, workspace);
+    }
+
+    // То же в рабочей памяти workspace (списки, ранги, события и активные горизонтали)
+    template <typename Sink>
+    void reportOrthogonalIntersections(Sink sink, SweepWorkspaceT<T>& workspace) const {
+        if (!isOrthogonal()) {
+            throw std::runtime_error("Sections are not axis-parallel");
+        }
+        int n = S.size();
+        auto report = [&](int a, int b) {
+            return !intersection(S[a], S[b], touch_policy) || reportOriginal(sink, a, b);
+        };
+
+        std::vector<int>& horizontal = workspace.horizontal;
+        std::vector<int>& vertical = workspace.vertical;
+        horizontal.clear();
+        vertical.clear();
+        for (int i = 0; i < n; ++i) {
+            (S[i].begin.y == S[i].end.y ? horizontal : vertical).push_back(i);
+        }
+
+        // 1. Коллинеарные пары
+        if (!reportCollinear(horizontal, true, report, workspace.collinear_active)) return;
+        if (!reportCollinear(vertical, false, report, workspace.collinear_active)) return;
+        if (horizontal.empty() || vertical.empty()) return;
+
+        // 2. Ранги y горизонталей
+        std::vector<double>& ys = workspace.ys;
+        ys.clear();
+        for (int id : horizontal) {
+            ys.push_back(S[id].begin.y);
+        }
+        std::sort(ys.begin(), ys.end());
+        ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+        int ranks = ys.size();
+
+        std::vector<int>& rank = workspace.rank;
+        rank.assign(n, -1);
+        for (int id : horizontal) {
+            rank[id] = int(std::lower_bound(ys.begin(), ys.end(), S[id].begin.y) - ys.begin());
+        }
+
+        // 3. События по x; при равном x: начало горизонтали, вертикаль, конец горизонтали
+        std::vector<OrthogonalEvent>& events = workspace.orthogonal_events;
+        events.clear();
+        for (int id : horizontal) {
+            events.push_back({ double(std::min(S[id].begin.x, S[id].end.x)), 0, id });
+            events.push_back({ double(std::max(S[id].begin.x, S[id].end.x)), 2, id });
+        }
+        for (int id : vertical) {
+            events.push_back({ double(S[id].begin.x), 1, id });
+        }
+        std::sort(events.begin(), events.end(), [](const OrthogonalEvent& a, const OrthogonalEvent& b) {
+            return a.x < b.x || (a.x == b.x && a.type < b.type);
+            });
+
+        // 4. Активные горизонтали: двусвязные списки по рангам
+        std::vector<int>& head = workspace.head;
+        std::vector<int>& next = workspace.next;
+        std::vector<int>& prev = workspace.prev;
+        head.assign(ranks, -1);
+        next.assign(n, -1);
+        prev.assign(n, -1);
+        RankSet& occupied = workspace.occupied;
+        occupied.reset(ranks);
+
+        for (const OrthogonalEvent& event : events) {
+            int id = event.id;
+            if (event.type == 0) {
+                int r = rank[id];
+                if (head[r] < 0) occupied.insert(r);
+                else prev[head[r]] = id;
+                next[id] = head[r];
+                prev[id] = -1;
+                head[r] = id;
+            }
+            else if (event.type == 2) {
+                int r = rank[id];
+                if (prev[id] >= 0) next[prev[id]] = next[id];
+                else head[r] = next[id];
+                if (next[id] >= 0) prev[next[id]] = prev[id];
+                if (head[r] < 0) occupied.erase(r);
+            }
+            else {
+                double y_min = std::min(S[id].begin.y, S[id].end.y);
+                double y_max = std::max(S[id].begin.y, S[id].end.y);
+                int lo = int(std::lower_bound(ys.begin(), ys.end(), y_min) - ys.begin());
+                int hi = int(std::upper_bound(ys.begin(), ys.end(), y_max) - ys.begin());
+                for (int r = lo < ranks ? occupied.next(lo) : -1; r >= 0 && r < hi; r = r + 1 < ranks ? occupied.next(r + 1) : -1) {
+                    for (int h = head[r]; h >= 0; h = next[h]) {
+                        if (!report(h, id)) return;
+                    }
+                }
+            }
+        }
+    }
+
+    // Наивный перебор всех пар за O(n^2), с тем же интерфейсом, что и reportIntersections.
+    // Внутренний цикл читает координаты из SoA-массивов подряд и отсеивает пары блоками
+    // BatchKernel; точную проверку intersection проходят только кандидаты
+    template <typename Sink>
+    void reportIntersectionsNaive(Sink sink) const {
+        SectionView v = view();
+
+        for (int i = 0; i < v.n - 1; ++i) {
+            section current = v[i];
+            BatchBlockT<T> row = v.block(i + 1, v.n - i - 1);
+            uint32_t mask;
+            for (int k = 0; (k = BatchKernel::scan(current.begin.x, current.begin.y, current.end.x, current.end.y, row, k, mask)) < row.count;
+                k += BatchKernel::BLOCK) {
+                for (int j = i + 1 + k; mask != 0; ++j, mask >>= 1) {
+                    if ((mask & 1) && intersection(current, v[j], touch_policy) && !reportOriginal(sink, i, j)) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+
+    // Число пар пересекающихся отрезков без перечисления самих пар.
+    // Ось x делится на полосы примерно по 2*sqrt(n) концов отрезков. Отрезки, проходящие полосу насквозь
+    // ("длинные"), пересекаются в ней ровно тогда, когда меняют порядок по y между её границами, -
+    // такие пары считаются как инверсии деревом Фенвика за O(L log L) на полосу. Пары с отрезком,
+    // у которого внутри полосы есть конец ("короткий"), и пары, почти совпадающие по y на границе,
+    // проверяются напрямую с отсечением по y. Каждая пара учитывается в той полосе,
+    // где лежит самая левая точка их пересечения.
+    long long countIntersections() const {
+        int n = S.size();
+        if (n < 2) return 0;
+
+        std::vector<LineCoeffs> lines;
+        prepareLines(lines);
+        double eps = sweepEps();
+        double inf = std::numeric_limits<double>::infinity();
+
+        // 1. Границы полос: каждый B-й по x конец отрезка
+        std::vector<double> xs;
+        xs.reserve(2 * n);
+        for (const section& sec : S) {
+            xs.push_back(sec.begin.x);
+            xs.push_back(sec.end.x);
+        }
+        std::sort(xs.begin(), xs.end());
+        size_t B = std::max(64, int(2 * std::sqrt(double(n))));
+        std::vector<double> bounds;
+        for (size_t k = 0; k < xs.size(); k += B) {
+            if (bounds.empty() || xs[k] > bounds.back()) {
+                bounds.push_back(xs[k]);
+            }
+        }
+        int slabs = bounds.size();
+
+        // 2. Полосы, где лежат левый и правый концы каждого отрезка; списки коротких отрезков по полосам
+        std::vector<int> first(n), last(n), start(slabs + 1, 0);
+        for (int i = 0; i < n; ++i) {
+            double x_min = std::min(S[i].begin.x, S[i].end.x);
+            double x_max = std::max(S[i].begin.x, S[i].end.x);
+            first[i] = int(std::upper_bound(bounds.begin(), bounds.end(), x_min) - bounds.begin()) - 1;
+            last[i] = int(std::upper_bound(bounds.begin(), bounds.end(), x_max) - bounds.begin()) - 1;
+            start[first[i] + 1]++;
+            if (last[i] != first[i]) start[last[i] + 1]++;
+        }
+        for (int t = 0; t < slabs; ++t) {
+            start[t + 1] += start[t];
+        }
+        std::vector<int> shorts(start[slabs]);
+        std::vector<int> fill(start.begin(), start.end() - 1);
+        for (int i = 0; i < n; ++i) {
+            shorts[fill[first[i]]++] = i;
+            if (last[i] != first[i]) shorts[fill[last[i]]++] = i;
+        }
+
+        std::vector<double> ya(n), yb(n), lo(n), hi(n);
+        std::vector<int> ra(n), rb(n), band_class(n);
+        std::vector<int> longs, by_a, by_b, local;
+        FenwickTree<long long> fenwick;
+        long long count = 0;
+
+        // Пара учитывается, если пересекается и самая левая общая точка лежит в полосе [a, b)
+        auto countPair = [&](int s, int t, double a, double b) {
+            if (!intersection(S[s], S[t], touch_policy)) return;
+            double x = firstCommonX(S[s], S[t]);
+            if (a <= x && x < b) ++count;
+        };
+
+        // Номера групп значений: соседние по возрастанию значения ближе eps попадают в одну группу
+        auto rankGroups = [&](std::vector<int>& ids, const std::vector<double>& value, std::vector<int>& group) {
+            std::sort(ids.begin(), ids.end(), [&](int u, int v) { return value[u] < value[v]; });
+            int groups = 0;
+            for (size_t k = 0; k < ids.size(); ++k) {
+                if (k > 0 && value[ids[k]] - value[ids[k - 1]] > eps) ++groups;
+                group[ids[k]] = groups;
+            }
+            return groups + 1;
+        };
+
+        for (int t = 0; t < slabs; ++t) {
+            double a = bounds[t];
+            double b = t + 1 < slabs ? bounds[t + 1] : inf;
+
+            // Длинные в полосе t: левый конец в полосе левее t, правый - правее t
+            longs.erase(std::remove_if(longs.begin(), longs.end(), [&](int i) { return last[i] <= t; }), longs.end());
+            if (t > 0) {
+                for (int k = start[t - 1]; k < start[t]; ++k) {
+                    int i = shorts[k];
+                    if (first[i] == t - 1 && last[i] > t) longs.push_back(i);
+                }
+            }
+
+            // 3. Длинные между собой: инверсии порядка по y на границах a и b
+            for (int i : longs) {
+                ya[i] = lines[i].y_at(a, 0);
+                yb[i] = lines[i].y_at(b, 0);
+                lo[i] = std::min(ya[i], yb[i]) - eps;
+                hi[i] = std::max(ya[i], yb[i]) + eps;
+            }
+            if (longs.size() > 1) {
+                by_a = longs;
+                by_b = longs;
+                rankGroups(by_a, ya, ra);
+                fenwick.reset(rankGroups(by_b, yb, rb));
+
+                // Пары из разных групп и на a, и на b пересекаются внутри полосы, если порядок обратный
+                long long inserted = 0;
+                for (size_t k = 0; k < by_a.size();) {
+                    size_t end = k;
+                    while (end < by_a.size() && ra[by_a[end]] == ra[by_a[k]]) ++end;
+                    for (size_t m = k; m < end; ++m) {
+                        count += inserted - fenwick.prefix(rb[by_a[m]] + 1);
+                    }
+                    for (size_t m = k; m < end; ++m) {
+                        fenwick.add(rb[by_a[m]], 1);
+                    }
+                    inserted += end - k;
+
+                    // Почти совпадающие на a - напрямую
+                    for (size_t u = k; u < end; ++u) {
+                        for (size_t v = u + 1; v < end; ++v) {
+                            countPair(by_a[u], by_a[v], a, b);
+                        }
+                    }
+                    k = end;
+                }
+
+                // Почти совпадающие на b (но не на a) - напрямую
+                for (size_t k = 0; k < by_b.size();) {
+                    size_t end = k;
+                    while (end < by_b.size() && rb[by_b[end]] == rb[by_b[k]]) ++end;
+                    for (size_t u = k; u < end; ++u) {
+                        for (size_t v = u + 1; v < end; ++v) {
+                            if (ra[by_b[u]] != ra[by_b[v]]) countPair(by_b[u], by_b[v], a, b);
+                        }
+                    }
+                    k = end;
+                }
+            }
 
-    // Лексикографическое сравнение, т е по x потом по y
-    bool operator<(const point& other) const {
-        return (x < other.x) || (x == other.x && y < other.y);
-    }
+            // 4. Короткие: диапазон y части отрезка внутри полосы
+            local.assign(shorts.begin() + start[t], shorts.begin() + start[t + 1]);
+            for (int i : local) {
+                if (lines[i].vertical()) {
+                    lo[i] = lines[i].y_min - eps;
+                    hi[i] = lines[i].y_max + eps;
+                    continue;
+                }
+                double x0 = std::max<double>(std::min(S[i].begin.x, S[i].end.x), a);
+                double x1 = std::min<double>(std::max(S[i].begin.x, S[i].end.x), b);
+                double y0 = lines[i].y_at(x0, 0);
+                double y1 = lines[i].y_at(x1, 0);
+                lo[i] = std::min(y0, y1) - eps;
+                hi[i] = std::max(y0, y1) + eps;
+            }
 
-    bool operator==(const point& other) const {
-        return x == other.x && y == other.y;
-    }
-};
+            // Короткие между собой: сортировка по нижнему краю и проход, пока диапазоны y перекрываются
+            std::sort(local.begin(), local.end(), [&](int u, int v) { return lo[u] < lo[v]; });
+            for (size_t u = 0; u < local.size(); ++u) {
+                for (size_t v = u + 1; v < local.size() && lo[local[v]] <= hi[local[u]]; ++v) {
+                    countPair(local[u], local[v], a, b);
+                }
+            }
 
-// Отрезок на плоскости
-struct section {
-    point begin;
-    point end;
+            // Короткие с длинными: длинные разбиты на классы по высоте (степени двойки) и
+            // отсортированы по нижнему краю, поэтому в каждом классе кандидаты - отрезок бинарного поиска
+            for (int i : longs) {
+                band_class[i] = std::ilogb(std::max(hi[i] - lo[i], eps));
+            }
+            std::sort(longs.begin(), longs.end(), [&](int u, int v) {
+                return band_class[u] != band_class[v] ? band_class[u] < band_class[v] : lo[u] < lo[v];
+                });
+            for (size_t k = 0; k < longs.size();) {
+                size_t end = k;
+                while (end < longs.size() && band_class[longs[end]] == band_class[longs[k]]) ++end;
+                double height = std::ldexp(1.0, band_class[longs[k]] + 1);
+
+                for (int s : local) {
+                    auto from = std::lower_bound(longs.begin() + k, longs.begin() + end, lo[s] - height,
+                        [&](int u, double value) { return lo[u] < value; });
+                    for (auto it = from; it != longs.begin() + end && lo[*it] <= hi[s]; ++it) {
+                        if (hi[*it] >= lo[s]) countPair(s, *it, a, b);
+                    }
+                }
+                k = end;
+            }
+        }
 
-    bool operator==(const section& other) const {
-        return begin == other.begin && end == other.end;
+        return count;
     }
-};
 
-// Структура для события - точки конца отрезка(для заметающей прямой)
-struct Event {
-    point p;            // Точка события
-    int segment_index;  // Индекс отрезка
-    bool is_left;       // true - левый конец, false - правый конец
-    
-    // Лексикографическое сравнение, т е по x потом по y
-    bool operator<(const Event& other) const {
-        return (p.x < other.p.x) || (p.x == other.p.x && p.y < other.p.y);
+    // Число пар пересекающихся отрезков перебором всех пар за O(n^2)
+    long long countIntersectionsNaive() const {
+        long long count = 0;
+        reportIntersectionsNaive([&](int, int) {
+            ++count;
+            return true;
+            });
+        return count;
     }
-};
-
-class SetSection {
-    std::vector<section> S;
-
-public:
-    SetSection() = default;
 
-    SetSection(point A, point B) {
-        section AB;
-        AB.begin = A;
-        AB.end = B;
-        if (AB.begin == AB.end) {
-            throw std::runtime_error("Section is point");
+    // Габаритный прямоугольник набора: begin - левый нижний угол, end - правый верхний
+    section boundingBox() const {
+        T inf = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+        T x_min = inf, y_min = inf, x_max = -inf, y_max = -inf;
+        SectionView v = view();
+        for (int i = 0; i < v.n; ++i) {
+            x_min = std::min(x_min, std::min(v.x0[i], v.x1[i]));
+            y_min = std::min(y_min, std::min(v.y0[i], v.y1[i]));
+            x_max = std::max(x_max, std::max(v.x0[i], v.x1[i]));
+            y_max = std::max(y_max, std::max(v.y0[i], v.y1[i]));
         }
-        S.push_back(AB);
+        return { { x_min, y_min }, { x_max, y_max } };
     }
 
-    void add_section(section sec) {
-        if (sec.begin == sec.end) {
-            throw std::runtime_error("It's point");
+    // Пересечения между двумя слоями: этот набор ("красный") и blue ("синий"), только пары из разных слоёв
+    // sink(i, j): i - индекс в этом наборе, j - в blue; если sink вернул false, поиск прекращается.
+    // Отрезки, не задевающие габаритный прямоугольник другого слоя, в проход не попадают;
+    // пересечения внутри слоя остаются событиями прохода (без них порядок на прямой неверен),
+    // но не проверяются и не выдаются
+    template <typename Sink>
+    void reportRedBlueIntersections(const SetSectionT& blue, Sink sink) const {
+        SetSectionT both;
+        both.touch_policy = touch_policy;
+        std::vector<int> origin;    // Индекс отрезка в своём слое
+
+        section blue_box = blue.boundingBox();
+        int n = S.size();
+        for (int i = 0; i < n; ++i) {
+            if (boxesOverlap(S[i], blue_box)) {
+                both.S.push_back(S[i]);
+                origin.push_back(i);
+            }
         }
-        S.push_back(sec);
+        int red_count = both.S.size();
+        if (red_count == 0) return;
+
+        section red_box = both.boundingBox();
+        int blue_n = blue.S.size();
+        for (int j = 0; j < blue_n; ++j) {
+            if (boxesOverlap(blue.S[j], red_box)) {
+                both.S.push_back(blue.S[j]);
+                origin.push_back(j);
+            }
+        }
+        if (int(both.S.size()) == red_count) return;
+        both.invalidate();  // S дополнен после подсчёта red_box
+
+        // Красные отрезки идут первыми, поэтому в паре a < b отрезок a - красный
+        both.sweepIntersections(
+            [&](int a, int b) { return (a < red_count) != (b < red_count); },
+            [&](int a, int b) { return sink(originalIndex(origin[a]), blue.originalIndex(origin[b])); });
     }
 
-    void add_section(point A, point B) {
-        section AB{ A, B };
-        if (AB.begin == AB.end) {
-            throw std::runtime_error("Section is point");
-        }
-        S.push_back(AB);
+    // Есть ли пересечение между слоями; s1 - отрезок этого набора, s2 - отрезок blue
+    bool intersectionRedBlue(const SetSectionT& blue, section& s1, section& s2) const {
+        bool found = false;
+        reportRedBlueIntersections(blue, [&](int i, int j) {
+            s1 = getSection(i);
+            s2 = blue.getSection(j);
+            found = true;
+            return false;
+            });
+        return found;
     }
 
-    size_t size() const {
-        return S.size();
+    // Статистика набора для модели стоимости - один проход за O(n)
+    SetStatistics statistics() const {
+        SetStatistics st{ int(S.size()), 0.0, 0.0, 0.0, 1.0 };
+        if (S.empty()) return st;
+
+        double total = 0;
+        int parallel = 0;
+        for (const section& sec : S) {
+            total += std::hypot(double(sec.end.x) - sec.begin.x, double(sec.end.y) - sec.begin.y);
+            if (sec.begin.x == sec.end.x || sec.begin.y == sec.end.y) ++parallel;
+        }
+        section box = boundingBox();
+        st.mean_length = total / S.size();
+        st.width = box.end.x - box.begin.x;
+        st.height = box.end.y - box.begin.y;
+        st.axis_parallel = double(parallel) / S.size();
+        return st;
     }
 
-    // Случайные координаты начала и конца
-    void generate_random_sections(int n, double min_coord = 0.0, double max_coord = 1.0) {
-        S.clear();
+    // Самый дешёвый по модели стоимости алгоритм для этого набора
+    SearchEngine chooseEngine() const {
+        SetStatistics st = statistics();
+        if (st.n < 2) return ENGINE_NAIVE;
+
+        SearchEngine best = ENGINE_NAIVE;
+        double best_cost = cost_model.naive(st);
+        auto consider = [&](SearchEngine engine, double cost) {
+            if (cost < best_cost) {
+                best = engine;
+                best_cost = cost;
+            }
+        };
+        consider(ENGINE_SWEEP, cost_model.sweep(st));
+        consider(ENGINE_GRID, cost_model.grid(st));
+        consider(ENGINE_ORTHOGONAL, cost_model.orthogonal(st));
+        consider(ENGINE_PRUNE, cost_model.prune(st));
+        return best;
+    }
 
-        for (int i = 0; i < n; ++i) {
-            section sec;
+    // Поиск пересечения алгоритмом, выбранным по модели стоимости
+    bool findIntersection(section& s1, section& s2) const {
+        return findIntersection(s1, s2, chooseEngine());
+    }
 
-            // Генерируем случайные координаты для начала отрезка
-            // Делим случайное число rand на RAND_MAX(2^15-1) и получаем дробное число от 0 до 1
-            sec.begin.x = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
-            sec.begin.y = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
+    // Поиск пересечения заданным алгоритмом
+    bool findIntersection(section& s1, section& s2, SearchEngine engine) const {
+        SweepWorkspaceT<T> workspace;
+        return findIntersection(s1, s2, engine, workspace);
+    }
 
-            // Генерируем случайные координаты для конца отрезка
-            sec.end.x = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
-            sec.end.y = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
+    // То же в рабочей памяти workspace - для повторных поисков без выделения памяти (см. SweepWorkspaceT)
+    bool findIntersection(section& s1, section& s2, SweepWorkspaceT<T>& workspace) const {
+        return findIntersection(s1, s2, chooseEngine(), workspace);
+    }
 
-            S.push_back(sec);
+    bool findIntersection(section& s1, section& s2, SearchEngine engine, SweepWorkspaceT<T>& workspace) const {
+        switch (engine) {
+        case ENGINE_NAIVE:
+            return intersectionNaive(s1, s2);
+        case ENGINE_GRID:
+            return intersectionGrid(s1, s2, workspace);
+        case ENGINE_ORTHOGONAL:
+            return firstOrthogonalIntersection(s1, s2, workspace);
+        case ENGINE_PRUNE:
+            return intersectionPrune(s1, s2, workspace);
+        default:
+            return intersectionEffective(s1, s2, workspace);
         }
     }
 
-    //генерация отрезков заданной длины со случайными центрами и углами
-    void generate_sections_fixed_length(int n, double segment_length, double min_coord = 0.0, double max_coord = 1.0) {
-        S.clear();
+    void setCostModel(const CostModel& model) {
+        cost_model = model;
+    }
+
+    const CostModel& costModel() const {
+        return cost_model;
+    }
 
+    // Калибровка модели стоимости на текущей машине: каждый алгоритм проходит набор без пересечений
+    // (параллельные отрезки), то есть выполняет всю работу, и время делится на число единиц работы.
+    // Наборы строятся своим генератором, последовательность rand() вызывающего кода не меняется.
+    // Целые координаты берутся в квадрате 10^6 x 10^6 (в единичном они бы округлились до нуля),
+    // направление отрезка округляется один раз, поэтому отрезки остаются точно параллельными
+    static CostModel calibrateCostModel(int n = 20000) {
+        std::mt19937 gen(12345);
+        const double scale = generatorRange();
+        std::uniform_real_distribution<double> coord(0.0, scale);
+        double length = 0.5 * scale / std::sqrt(double(n));
+
+        auto parallelSet = [&](int count, double angle) {
+            SetSectionT set;
+            T dx = toCoord(length * std::cos(angle));
+            T dy = toCoord(length * std::sin(angle));
+            for (int i = 0; i < count; ++i) {
+                point a{ toCoord(coord(gen)), toCoord(coord(gen)) };
+                set.add_section(a, { T(a.x + dx), T(a.y + dy) });
+            }
+            return set;
+        };
+        auto seconds = [](const SetSectionT& set, SearchEngine engine) {
+            section s1, s2;
+            auto start = std::chrono::steady_clock::now();
+            set.findIntersection(s1, s2, engine);
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        CostModel model;
+        SetSectionT slanted = parallelSet(n, 0.3);
+        SetStatistics st = slanted.statistics();
+
+        SetSectionT small = parallelSet(std::min(n, 2000), 0.3);
+        model.naive_pair = seconds(small, ENGINE_NAIVE) / (0.5 * small.S.size() * (small.S.size() - 1.0));
+
+        double events = 2.0 * n;
+        model.sweep_event = seconds(slanted, ENGINE_SWEEP) / (events * std::log2(events));
+
+        // Горизонтали в нижней половине, вертикали в верхней: запросы вертикалей проходят, но ничего не находят
+        SetSectionT orthogonal;
+        T step = toCoord(length);
         for (int i = 0; i < n; ++i) {
-            section sec;
+            point a{ toCoord(coord(gen)), toCoord(0.5 * coord(gen)) };
+            if (i % 2) {
+                a.y += toCoord(0.5 * scale);
+                orthogonal.add_section(a, { a.x, T(a.y + step) });
+            }
+            else {
+                orthogonal.add_section(a, { T(a.x + step), a.y });
+            }
+        }
+        model.orthogonal_event = seconds(orthogonal, ENGINE_ORTHOGONAL) / (events * std::log2(events));
+
+        // Проверка пары в клетке стоит столько же, сколько в переборе; остаток времени - на занесение в клетки
+        CostModel unit;
+        unit.grid_item = 1.0;
+        unit.grid_pair = 0.0;
+        double items = unit.grid(st);
+        unit.grid_item = 0.0;
+        unit.grid_pair = 1.0;
+        double pairs = unit.grid(st);
+        model.grid_pair = model.naive_pair;
+        model.grid_item = std::max(seconds(slanted, ENGINE_GRID) - pairs * model.grid_pair, 0.0) / items;
+
+        // Так же для sweep-and-prune: пары окна проверяет тот же векторный проход, остаток - сортировка
+        unit.prune_item = 1.0;
+        unit.prune_pair = 0.0;
+        double sorted = unit.prune(st);
+        unit.prune_item = 0.0;
+        unit.prune_pair = 1.0;
+        double window = unit.prune(st);
+        model.prune_pair = model.naive_pair;
+        model.prune_item = std::max(seconds(slanted, ENGINE_PRUNE) - window * model.prune_pair, 0.0) / sorted;
+        return model;
+    }
 
-            // Генерируем случайные координаты центра отрезка
-            double center_x = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
-            double center_y = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
+    // Поиск пересечений по равномерной сетке: каждый отрезок заносится во все клетки, которые он задевает,
+    // и intersection() проверяется только для пар из одной клетки. Сторона клетки по умолчанию -
+    // средняя длина отрезка (но клеток не больше ~2n), поэтому для коротких отрезков одинаковой длины
+    // ожидаемое время почти линейно. Пара, попавшая в несколько общих клеток, выдаётся один раз -
+    // в первой из них. sink(i, j) с i < j; если sink вернул false, поиск прекращается
+    template <typename Sink>
+    void reportGridIntersections(Sink sink, double cell_size = 0.0) const {
+        SweepWorkspaceT<T> workspace;
+        reportGridIntersections(sink, workspace, cell_size);
+    }
 
-            // Генерируем случайный угол с осью абсцисс (в радианах)
-            double angle = (double)rand() / RAND_MAX * 2 * M_PI; // от 0 до 2pi
+    // То же с CSR-массивами клеток в рабочей памяти workspace
+    template <typename Sink>
+    void reportGridIntersections(Sink sink, SweepWorkspaceT<T>& workspace, double cell_size = 0.0) const {
+        int n = S.size();
+        if (n < 2) return;
 
-            // Вычисляем координаты концов отрезка(тригонометрия)
-            double half_length = segment_length / 2.0;
-            double dx = half_length * cos(angle);       // Проекция на Ox
-            double dy = half_length * sin(angle);       // Проекция на Oy
+        UniformGrid grid(*this, cell_size);
 
-            sec.begin.x = center_x - dx;
-            sec.begin.y = center_y - dy;
-            sec.end.x = center_x + dx;
-            sec.end.y = center_y + dy;
+        // 1. Клетки отрезков в CSR-виде: сначала подсчёт, затем заполнение
+        std::vector<int>& start = workspace.grid_start;
+        start.assign(grid.cells() + 1, 0);
+        for (int i = 0; i < n; ++i) {
+            grid.forEachCell(S[i], [&](size_t cell) { start[cell + 1]++; });
+        }
+        for (size_t cell = 0; cell < grid.cells(); ++cell) {
+            start[cell + 1] += start[cell];
+        }
+        std::vector<int>& items = workspace.grid_items;
+        std::vector<int>& fill = workspace.grid_fill;
+        items.resize(start.back());
+        fill.assign(start.begin(), start.end() - 1);
+        for (int i = 0; i < n; ++i) {
+            grid.forEachCell(S[i], [&](size_t cell) { items[fill[cell]++] = i; });
+        }
 
-            S.push_back(sec);
+        // 2. Пары внутри клеток
+        for (size_t cell = 0; cell < grid.cells(); ++cell) {
+            for (int a = start[cell]; a < start[cell + 1]; ++a) {
+                for (int b = a + 1; b < start[cell + 1]; ++b) {
+                    int i = items[a];
+                    int j = items[b];
+                    if (!intersection(S[i], S[j], touch_policy)) continue;
+                    if (grid.firstCommonCell(S[i], S[j]) != cell) continue;
+                    if (!reportOriginal(sink, i, j)) return;
+                }
+            }
         }
     }
 
-    // Непосредственный ввод координат концов отрезкА
-    void input_single_section() {
-        section sec;
-        std::cout << "Введите координаты отрезка:\n";
-        std::cout << "Начальная точка (x y): ";
-        std::cin >> sec.begin.x >> sec.begin.y;
-        std::cout << "Конечная точка (x y): ";
-        std::cin >> sec.end.x >> sec.end.y;
+    // Поиск пересечения по равномерной сетке до первой найденной пары
+    bool intersectionGrid(section& s1, section& s2, double cell_size = 0.0) const {
+        SweepWorkspaceT<T> workspace;
+        return intersectionGrid(s1, s2, workspace, cell_size);
+    }
 
-        S.push_back(sec);
+    bool intersectionGrid(section& s1, section& s2, SweepWorkspaceT<T>& workspace, double cell_size = 0.0) const {
+        bool found = false;
+        reportGridIntersections([&](int i, int j) {
+            s1 = getSection(i);
+            s2 = getSection(j);
+            found = true;
+            return false;
+            }, workspace, cell_size);
+        return found;
     }
 
-    //непосредственный ввод координат концов отрезкОВ
-    void input_sections_count(int n) {
-        S.clear();
+    // Sweep-and-prune по x-интервалам: отрезки один раз сортируются по левому краю, и для каждого
+    // просматриваются следующие за ним, пока их левый край не правее его правого края. Окно проходит
+    // BatchKernel::scan над SoA-копией в порядке сортировки: прямоугольники (в том числе y-интервалы)
+    // и ориентации отсекаются векторно, intersection() проверяет только оставшиеся биты маски.
+    // Память читается подряд, дерева нет; время - O(n log n) плюс число пар с пересекающимися x-интервалами,
+    // поэтому режим рассчитан на короткие отрезки. sink(i, j) с i < j; если sink вернул false, поиск прекращается
+    template <typename Sink>
+    void reportPruneIntersections(Sink sink) const {
+        SweepWorkspaceT<T> workspace;
+        reportPruneIntersections(sink, workspace);
+    }
 
-        for (int i = 0; i < n; ++i) {
-            section sec;
-            std::cout << "Отрезок " << i + 1 << ":\n";
+    // То же в рабочей памяти workspace (порядок, упорядоченная копия и её SoA-массивы)
+    template <typename Sink>
+    void reportPruneIntersections(Sink sink, SweepWorkspaceT<T>& workspace) const {
+        int n = S.size();
+        if (n < 2) return;
 
-            std::cout << "  Начальная точка (x y): ";
-            std::cin >> sec.begin.x >> sec.begin.y;
+        SectionView v = view();
+        std::vector<int>& order = workspace.order;
+        order.resize(n);
+        for (int i = 0; i < n; ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return v.xmin[a] < v.xmin[b]; });
 
-            std::cout << "  Конечная точка (x y): ";
-            std::cin >> sec.end.x >> sec.end.y;
+        std::vector<section>& sorted = workspace.sorted;
+        sorted.resize(n);
+        for (int k = 0; k < n; ++k) {
+            sorted[k] = S[order[k]];
+        }
+        SectionArraysT<T>& lanes = workspace.lanes;
+        lanes.assign(sorted);
+        SectionView w = lanes.view();
 
-            if (sec.begin == sec.end) {
-                throw std::runtime_error("Section is point");
+        for (int i = 0; i < n - 1; ++i) {
+            // Окно: отрезки, левый край которых не правее правого края i
+            int end = int(std::upper_bound(w.xmin + i + 1, w.xmin + n, w.xmax[i]) - w.xmin);
+            if (end == i + 1) continue;
+
+            section current = w[i];
+            BatchBlockT<T> row = w.block(i + 1, end - i - 1);
+            uint32_t mask;
+            for (int k = 0; (k = BatchKernel::scan(current.begin.x, current.begin.y, current.end.x, current.end.y, row, k, mask)) < row.count;
+                k += BatchKernel::BLOCK) {
+                for (int j = i + 1 + k; mask != 0; ++j, mask >>= 1) {
+                    if ((mask & 1) && intersection(current, w[j], touch_policy) && !reportOriginal(sink, order[i], order[j])) {
+                        return;
+                    }
+                }
             }
-            S.push_back(sec);
         }
     }
 
-    // Проверка пересечений
-    bool intersection(section AB, section CD) const {
-        point A = AB.begin;
-        point B = AB.end;
-        point C = CD.begin;
-        point D = CD.end;
-
-        // Как точка лежит относительно отрезка
-        int ABC = side(A, B, C);
-        int ABD = side(A, B, D);
-        int CDA = side(C, D, A);
-        int CDB = side(C, D, B);
-
-        // Лежит ли точка на отрезке
-        if (ABC == 0 || ABD == 0 || CDA == 0 || CDB == 0) return true;
-
-        if (ABC != ABD && CDA != CDB) return true;
-        return false;
+    // Поиск пересечения sweep-and-prune до первой найденной пары
+    bool intersectionPrune(section& s1, section& s2) const {
+        SweepWorkspaceT<T> workspace;
+        return intersectionPrune(s1, s2, workspace);
     }
 
-    int side(point A, point B, point C) const {
-        // Векторное произведенме (B-A)*(C-A) or AB*AC
-        double det = (B.x - A.x) * (C.y - A.y) - (B.y - A.y) * (C.x - A.x);
+    bool intersectionPrune(section& s1, section& s2, SweepWorkspaceT<T>& workspace) const {
+        bool found = false;
+        reportPruneIntersections([&](int i, int j) {
+            s1 = getSection(i);
+            s2 = getSection(j);
+            found = true;
+            return false;
+            }, workspace);
+        return found;
+    }
 
-        if (det > 0) return 1;		//left
-        else if (det < 0) return 2; //right
-        return 0;					//on AB
+private:
+    // Задевает ли отрезок прямоугольник box (по габаритам)
+    static bool boxesOverlap(const section& sec, const section& box) {
+        return std::max(sec.begin.x, sec.end.x) >= box.begin.x && std::min(sec.begin.x, sec.end.x) <= box.end.x &&
+            std::max(sec.begin.y, sec.end.y) >= box.begin.y && std::min(sec.begin.y, sec.end.y) <= box.end.y;
     }
 
-    // Наивный алгоритм поиска пересечения за O(n^2)
-    bool intersectionNaive(section& s1, section& s2) const {
-        int n = S.size();
+    // Пересекаются ли габаритные прямоугольники двух отрезков
+    static bool boxesIntersect(const section& AB, const section& CD) {
+        return std::max(AB.begin.x, AB.end.x) >= std::min(CD.begin.x, CD.end.x) &&
+            std::max(CD.begin.x, CD.end.x) >= std::min(AB.begin.x, AB.end.x) &&
+            std::max(AB.begin.y, AB.end.y) >= std::min(CD.begin.y, CD.end.y) &&
+            std::max(CD.begin.y, CD.end.y) >= std::min(AB.begin.y, AB.end.y);
+    }
 
-        for (int i = 0; i < n - 1; ++i) {
-            for (int j = i + 1; j < n; ++j) {
-                if (intersection(S[i], S[j])) {
-                    s1 = S[i];
-                    s2 = S[j];
-                    return true;
+    // Равномерная сетка над габаритным прямоугольником набора; клетки нумеруются по столбцам.
+    // Клетки отрезка в столбце c - диапазон строк, задетых его частью внутри столбца (с запасом eps),
+    // поэтому общая точка двух отрезков всегда попадает в клетку, общую для обоих
+    struct UniformGrid {
+        double x0, y0;      // Левый нижний угол
+        double h;           // Сторона клетки
+        double eps;
+        int columns, rows;
+
+        UniformGrid(const SetSectionT& set, double cell_size) {
+            section box = set.boundingBox();
+            x0 = box.begin.x;
+            y0 = box.begin.y;
+            double width = box.end.x - box.begin.x;
+            double height = box.end.y - box.begin.y;
+            int n = set.S.size();
+
+            h = cell_size;
+            if (h <= 0) {
+                double total = 0;
+                for (const section& sec : set.S) {
+                    total += std::hypot(double(sec.end.x) - sec.begin.x, double(sec.end.y) - sec.begin.y);
                 }
+                h = std::max(total / n, std::sqrt(width * height / (2.0 * n)));
             }
-        }
-        return false;
-    }
+            // Не больше ~2n столбцов и строк даже для набора, вытянутого вдоль прямой
+            h = std::max({ h, width / (2.0 * n), height / (2.0 * n) });
+            if (!(h > 0)) h = 1;    // все отрезки - в одной точке: одна клетка
+            eps = set.sweepEps();
 
-    // Доступ к отрезкам по индексам
-    const section& getSection(int index) const {
-        if (index < 0 || index >= S.size()) {
-            throw std::out_of_range("Invalid section index");
+            columns = int(width / h) + 1;
+            rows = int(height / h) + 1;
         }
-        return S[index];
-    }
 
-    section& getSection(int index) {
-        if (index < 0 || index >= S.size()) {
-            throw std::out_of_range("Invalid section index");
+        size_t cells() const {
+            return size_t(columns) * rows;
         }
-        return S[index];
-    }
 
-public:
-    // Вычисляет y-координату пересечения отрезка с вертикальной линией x
-    double get_y_at_x(const section& seg, double x) const {
-        //Проверка на вертикальную прямую(т е верхняя и нижняя точка лежат на одном x)
-        if (std::abs(seg.end.x - seg.begin.x) < 1e-9) {
-            // Вертикальный отрезок - возвращаем среднее y
-            return (seg.begin.y + seg.end.y) / 2.0;
+        int column(double x) const {
+            return std::min(std::max(int(std::floor((x - x0) / h)), 0), columns - 1);
         }
-        // Линейная интерполяция: y = y1 + (y2-y1)*(x-x1)/(x2-x1)
-        return seg.begin.y + (seg.end.y - seg.begin.y) *
-            (x - seg.begin.x) / (seg.end.x - seg.begin.x);
-    }
-    // Эффективный алгоритм поиска пересечения за O(n log n) с использованием AVL-дерева
-    bool intersectionEffective(section& s1, section& s2) {
-        if (S.empty()) return false;
-    
-        // 1. Создаем массив событий
-        std::vector<Event> events;
-        for (int i = 0; i < S.size(); ++i) {
-            // Убеждаемся, что левый конец имеет меньшую x-координату
-            point left = S[i].begin;
-            point right = S[i].end;
-            
-            // Иначе меняем местами лево и право
-            if (right < left) {
-                std::swap(left, right);
-            }
-    
-            events.push_back({ left, i, true });  // левый конец
-            events.push_back({ right, i, false }); // правый конец
+
+        int row(double y) const {
+            return std::min(std::max(int(std::floor((y - y0) / h)), 0), rows - 1);
         }
-    
-        // 2. Лексикографическая сортировка событий
-        std::sort(events.begin(), events.end());
-    
-        // 3. АВЛ-дерево для хранения активных отрезков (ключ - y-координата при текущем x)
-        AVLTree<double, int> active_segments;
-        double current_x = 0;
-    
-        // 4. Обработка событий слева направо
-        for (const auto& event : events) {
-            current_x = event.p.x;
-            int seg_id = event.segment_index;
-            const section& current_seg = S[seg_id];
-    
-            if (event.is_left) {
-                // Вставка отрезка в дерево активных
-                double y_key = get_y_at_x(current_seg, current_x);
-                active_segments.insert(y_key, seg_id);
-    
-                // Находим соседей в дереве с помощью готовых методов
-                try {
-                    // Поиск предшественника (ПОД) - O(log n)
-                    double pred_key;
-                    int pred_id = -1;
-                    if (active_segments.predecessor(y_key, pred_key, pred_id)) {
-                        // Проверка пересечения с предшественником
-                        if (intersection(S[pred_id], current_seg)) {
-                            s1 = S[pred_id];
-                            s2 = current_seg;
-                            return true;
-                        }
-                    }
-    
-                    // Поиск преемника (НАД) - O(log n)
-                    double succ_key;
-                    int succ_id = -1;
-                    if (active_segments.successor(y_key, succ_key, succ_id)) {
-                        // Проверка пересечения с преемником
-                        if (intersection(S[succ_id], current_seg)) {
-                            s1 = S[succ_id];
-                            s2 = current_seg;
-                            return true;
-                        }
-                    }
-                }
-                catch (...) {
-                    // Игнорируем ошибки при поиске соседей
-                }
-    
+
+        // Строки клеток, которые отрезок задевает в столбце c; false - отрезок не заходит в столбец
+        bool rowRange(const section& sec, int c, int& r0, int& r1) const {
+            double x_min = std::min(sec.begin.x, sec.end.x);
+            double x_max = std::max(sec.begin.x, sec.end.x);
+            if (c < column(x_min) || c > column(x_max)) return false;
+
+            double y_lo, y_hi;
+            if (sec.begin.x == sec.end.x) {
+                y_lo = std::min(sec.begin.y, sec.end.y);
+                y_hi = std::max(sec.begin.y, sec.end.y);
             }
             else {
-                // Удаление отрезка из дерева активных
-                double y_key = get_y_at_x(current_seg, current_x);
-    
-                // Находим соседей перед удалением с помощью готовых методов
-                try {
-                    // Поиск предшественника и преемника - O(log n)
-                    double pred_key, succ_key;
-                    int pred_id = -1, succ_id = -1;
-    
-                    bool has_pred = active_segments.predecessor(y_key, pred_key, pred_id);
-                    bool has_succ = active_segments.successor(y_key, succ_key, succ_id);
-    
-                    // Проверка пересечения между соседями
-                    if (has_pred && has_succ && intersection(S[pred_id], S[succ_id])) {
-                        s1 = S[pred_id];
-                        s2 = S[succ_id];
-                        return true;
-                    }
-                }
-                catch (...) {
-                    // Игнорируем ошибки
-                }
-    
-                // Удаляем отрезок из дерева
-                try {
-                    active_segments.erase(y_key);
-                }
-                catch (...) {
-                    // Игнорируем ошибки удаления
-                }
+                double xa = std::max(x_min, x0 + c * h - eps);
+                double xb = std::min(x_max, x0 + (c + 1) * h + eps);
+                double k = (double(sec.end.y) - sec.begin.y) / (double(sec.end.x) - sec.begin.x);
+                double ya = sec.begin.y + k * (xa - sec.begin.x);
+                double yb = sec.begin.y + k * (xb - sec.begin.x);
+                y_lo = std::max<double>(std::min(ya, yb), std::min(sec.begin.y, sec.end.y));
+                y_hi = std::min<double>(std::max(ya, yb), std::max(sec.begin.y, sec.end.y));
             }
+            r0 = row(y_lo - eps);
+            r1 = row(y_hi + eps);
+            return true;
         }
-    
-        return false;
-    }
-
-    // Версия эффективного алгоритма с предварительно подготовленными событиями(для правильного счёта времени T2: отсортированные события)
-    bool intersectionEffectiveWithPreparedEvents(section& s1, section& s2, const std::vector<Event>& events) {
-        if (S.empty()) return false;
-
-        // АВЛ-дерево для хранения активных отрезков
-        AVLTree<double, int> active_segments;
-        double current_x = 0;
-
-        // Обработка уже отсортированных событий (только работа с AVL-деревом)
-        for (const auto& event : events) {
-            current_x = event.p.x;
-            int seg_id = event.segment_index;
-            const section& current_seg = S[seg_id];
-
-            if (event.is_left) {
-                // Вставка отрезка
-                double y_key = get_y_at_x(current_seg, current_x);
-                active_segments.insert(y_key, seg_id);
-
-                // Находим соседей в дереве с помощью successor и predecessor
-                try {
-                    // Поиск предшественника (ПОД) - O(log n)
-                    double pred_key;
-                    int pred_id = -1;
-                    if (active_segments.predecessor(y_key, pred_key, pred_id)) {
-                        // Проверка пересечения с предшественником
-                        if (intersection(S[pred_id], current_seg)) {
-                            s1 = S[pred_id];
-                            s2 = current_seg;
-                            return true;
-                        }
-                    }
 
-                    // Поиск преемника (НАД) - O(log n)
-                    double succ_key;
-                    int succ_id = -1;
-                    if (active_segments.successor(y_key, succ_key, succ_id)) {
-                        // Проверка пересечения с преемником
-                        if (intersection(S[succ_id], current_seg)) {
-                            s1 = S[succ_id];
-                            s2 = current_seg;
-                            return true;
-                        }
-                    }
+        template <typename F>
+        void forEachCell(const section& sec, F f) const {
+            int c0 = column(std::min(sec.begin.x, sec.end.x));
+            int c1 = column(std::max(sec.begin.x, sec.end.x));
+            for (int c = c0; c <= c1; ++c) {
+                int r0, r1;
+                if (!rowRange(sec, c, r0, r1)) continue;
+                for (int r = r0; r <= r1; ++r) {
+                    f(size_t(c) * rows + r);
                 }
-                catch (...) {
-                    // Игнорируем ошибки при поиске соседей
-                }
-
             }
-            else {
-                // Удаление отрезка
-                double y_key = get_y_at_x(current_seg, current_x);
-
-                // Находим соседей перед удалением с помощью successor и predecessor
-                try {
-                    // Поиск предшественника и преемника - O(log n)
-                    double pred_key, succ_key;
-                    int pred_id = -1, succ_id = -1;
-
-                    bool has_pred = active_segments.predecessor(y_key, pred_key, pred_id);
-                    bool has_succ = active_segments.successor(y_key, succ_key, succ_id);
-
-                    // Проверка пересечения между соседями
-                    if (has_pred && has_succ && intersection(S[pred_id], S[succ_id])) {
-                        s1 = S[pred_id];
-                        s2 = S[succ_id];
-                        return true;
-                    }
-                }
-                catch (...) {
-                    // Игнорируем ошибки
-                }
+        }
 
-                // Удаляем отрезок из дерева
-                try {
-                    active_segments.erase(y_key);
-                }
-                catch (...) {
-                    // Игнорируем ошибки удаления
+        // Первая (по номеру) клетка, общая для двух отрезков
+        size_t firstCommonCell(const section& AB, const section& CD) const {
+            int c0 = std::max(column(std::min(AB.begin.x, AB.end.x)), column(std::min(CD.begin.x, CD.end.x)));
+            int c1 = std::min(column(std::max(AB.begin.x, AB.end.x)), column(std::max(CD.begin.x, CD.end.x)));
+            for (int c = c0; c <= c1; ++c) {
+                int a0, a1, b0, b1;
+                if (!rowRange(AB, c, a0, a1) || !rowRange(CD, c, b0, b1)) continue;
+                if (std::max(a0, b0) <= std::min(a1, b1)) {
+                    return size_t(c) * rows + std::max(a0, b0);
                 }
             }
+            return cells();
         }
+    };
 
-        return false;
-    }
-
-    // Упрощенная версия эффективного алгоритма (только проверка факта пересечения)
-    bool hasIntersectionEffective() {
-        section s1, s2;
-        return intersectionEffective(s1, s2);
-    }
-
+public:
 // Генерация отрезков с контролируемыми пересечениями (случайные координаты)
-    void generate_controlled_sections(int n, int k, double min_coord = 0.0, double max_coord = 1.0) {
-        S.clear();
+    void generate_controlled_sections(int n, int k, double min_coord = 0.0, double max_coord = generatorRange()) {
+        clearSections();
+        checkGeneratorSize(max_coord - min_coord);
+        auto at = [&](double share) { return toCoord(min_coord + share * (max_coord - min_coord)); };
 
         // 1. Генерируем k непересекающихся отрезков
         for (int i = 0; i < k; ++i) {
@@ -447,10 +2607,10 @@ public:
 
             while (!valid && attempts < 100) {
                 // Генерируем случайные координаты
-                sec.begin.x = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
-                sec.begin.y = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
-                sec.end.x = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
-                sec.end.y = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
+                sec.begin.x = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+                sec.begin.y = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+                sec.end.x = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+                sec.end.y = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
 
                 // Проверяем, что отрезок не вырожден
                 if (sec.begin == sec.end) continue;
@@ -471,10 +2631,11 @@ public:
             }
             else {
                 // Если не удалось сгенерировать непересекающийся отрезок, создаем очень короткий
-                sec.begin.x = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
-                sec.begin.y = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
-                sec.end.x = sec.begin.x + 0.001;
-                sec.end.y = sec.begin.y + 0.001;
+                T tick = std::max(toCoord(0.001 * (max_coord - min_coord)), std::is_integral<T>::value ? T(1) : T(0));
+                sec.begin.x = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+                sec.begin.y = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+                sec.end.x = sec.begin.x + tick;
+                sec.end.y = sec.begin.y + tick;
                 S.push_back(sec);
             }
         }
@@ -482,37 +2643,29 @@ public:
         // 2. Добавляем два пересекающихся отрезка (k+1 и k+2)
         if (n > k) {
             // Первый пересекающийся отрезок
-            section sec1;
-            sec1.begin.x = 0.3;
-            sec1.begin.y = 0.3;
-            sec1.end.x = 0.7;
-            sec1.end.y = 0.7;
-            S.push_back(sec1);
+            add_section({ at(0.3), at(0.3) }, { at(0.7), at(0.7) });
 
             // Второй пересекающийся отрезок (пересекается с первым)
-            section sec2;
-            sec2.begin.x = 0.3;
-            sec2.begin.y = 0.7;
-            sec2.end.x = 0.7;
-            sec2.end.y = 0.3;
-            S.push_back(sec2);
+            add_section({ at(0.3), at(0.7) }, { at(0.7), at(0.3) });
         }
 
         // 3. Добавляем оставшиеся случайные отрезки
-        for (int i = k + 2; i < n; ++i) {
+        for (int i = k + 2; i < n; ) {
             section sec;
-            sec.begin.x = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
-            sec.begin.y = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
-            sec.end.x = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
-            sec.end.y = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
-            S.push_back(sec);
+            sec.begin.x = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+            sec.begin.y = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+            sec.end.x = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+            sec.end.y = toCoord(min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord));
+            if (pushGenerated(sec)) ++i;
         }
     }
 
     // Генерация отрезков фиксированной длины с контролируемыми пересечениями
     void generate_controlled_fixed_length_sections(int n, int k, double segment_length,
-        double min_coord = 0.0, double max_coord = 1.0) {
-        S.clear();
+        double min_coord = 0.0, double max_coord = generatorRange()) {
+        clearSections();
+        checkGeneratorSize(segment_length);
+        auto at = [&](double share) { return toCoord(min_coord + share * (max_coord - min_coord)); };
 
         // 1. Генерируем k непересекающихся отрезков фиксированной длины
         for (int i = 0; i < k; ++i) {
@@ -531,10 +2684,11 @@ public:
                 double dx = half_length * cos(angle);
                 double dy = half_length * sin(angle);
 
-                sec.begin.x = center_x - dx;
-                sec.begin.y = center_y - dy;
-                sec.end.x = center_x + dx;
-                sec.end.y = center_y + dy;
+                sec.begin.x = toCoord(center_x - dx);
+                sec.begin.y = toCoord(center_y - dy);
+                sec.end.x = toCoord(center_x + dx);
+                sec.end.y = toCoord(center_y + dy);
+                if (sec.begin == sec.end) continue;
 
                 // Проверяем, что отрезок находится в пределах области
                 if (sec.begin.x < min_coord || sec.begin.x > max_coord ||
@@ -563,24 +2717,14 @@ public:
         // 2. Добавляем два пересекающихся отрезка (k+1 и k+2)
         if (n > k) {
             // Первый пересекающийся отрезок
-            section sec1;
-            sec1.begin.x = 0.4;
-            sec1.begin.y = 0.4;
-            sec1.end.x = 0.6;
-            sec1.end.y = 0.6;
-            S.push_back(sec1);
+            add_section({ at(0.4), at(0.4) }, { at(0.6), at(0.6) });
 
             // Второй пересекающийся отрезок (пересекается с первым)
-            section sec2;
-            sec2.begin.x = 0.4;
-            sec2.begin.y = 0.6;
-            sec2.end.x = 0.6;
-            sec2.end.y = 0.4;
-            S.push_back(sec2);
+            add_section({ at(0.4), at(0.6) }, { at(0.6), at(0.4) });
         }
 
         // 3. Добавляем оставшиеся отрезки фиксированной длины
-        for (int i = k + 2; i < n; ++i) {
+        for (int i = k + 2; i < n; ) {
             section sec;
 
             double center_x = min_coord + (double)rand() / RAND_MAX * (max_coord - min_coord);
@@ -591,12 +2735,16 @@ public:
             double dx = half_length * cos(angle);
             double dy = half_length * sin(angle);
 
-            sec.begin.x = center_x - dx;
-            sec.begin.y = center_y - dy;
-            sec.end.x = center_x + dx;
-            sec.end.y = center_y + dy;
+            sec.begin.x = toCoord(center_x - dx);
+            sec.begin.y = toCoord(center_y - dy);
+            sec.end.x = toCoord(center_x + dx);
+            sec.end.y = toCoord(center_y + dy);
 
-            S.push_back(sec);
+            if (pushGenerated(sec)) ++i;
         }
     }
-};
\ No newline at end of file
+};
+
+typedef SetSectionT<double> SetSection;
+typedef SetSectionT<float> SetSectionFloat;
+typedef SetSectionT<int32_t> SetSectionInt;
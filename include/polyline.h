@@ -0,0 +1,230 @@
+#ifndef OTREZKI_POLYLINE_H
+#define OTREZKI_POLYLINE_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "otrezki.h"
+#include "sweep_status.h"
+
+// Ломаная (или замкнутый контур многоугольника), заданная списком вершин.
+// Ребро i соединяет вершины i и i+1; у замкнутой ломаной последнее ребро возвращается в вершину 0.
+// Соседние рёбра имеют общую вершину по построению, поэтому их касание в ней пересечением не считается.
+class Polyline {
+    std::vector<point> V;
+    bool closed;
+
+public:
+    explicit Polyline(bool is_closed = false) : closed(is_closed) {}
+
+    explicit Polyline(std::vector<point> vertices, bool is_closed = false)
+        : V(std::move(vertices)), closed(is_closed) {}
+
+    void add_vertex(point p) {
+        V.push_back(p);
+    }
+
+    size_t size() const {
+        return V.size();
+    }
+
+    bool isClosed() const {
+        return closed;
+    }
+
+    int edgeCount() const {
+        return edgeCount(V.size(), closed);
+    }
+
+    const point& getVertex(int index) const {
+        if (index < 0 || index >= int(V.size())) {
+            throw std::out_of_range("Invalid vertex index");
+        }
+        return V[index];
+    }
+
+    section getEdge(int index) const {
+        if (index < 0 || index >= edgeCount()) {
+            throw std::out_of_range("Invalid edge index");
+        }
+        return { V[index], V[(index + 1) % V.size()] };
+    }
+
+    // Простая ломаная: несоседние рёбра не имеют общих точек, соседние - только общую вершину
+    bool isSimple() const {
+        int e1, e2;
+        return !findSelfIntersection(V.data(), V.size(), closed, e1, e2);
+    }
+
+    // Первая найденная пара рёбер-нарушителей (e1 <= e2; e1 == e2 - ребро нулевой длины) за O(n log n)
+    bool findSelfIntersection(int& e1, int& e2) const {
+        return findSelfIntersection(V.data(), V.size(), closed, e1, e2);
+    }
+
+    bool findSelfIntersectionNaive(int& e1, int& e2) const {
+        return findSelfIntersectionNaive(V.data(), V.size(), closed, e1, e2);
+    }
+
+    // Проверка прямо по массиву вершин вызывающего кода - без копирования в Polyline и в отрезки.
+    // У замкнутого контура повтор первой вершины в конце (как принято в GIS-форматах) допускается.
+    static bool isSimple(const point* v, size_t n, bool closed) {
+        int e1, e2;
+        return !findSelfIntersection(v, n, closed, e1, e2);
+    }
+
+    // Шамос–Хоуи по вершинам: событиями служат сами вершины, отсортированные лексикографически
+    // (в каждой начинаются или заканчиваются не более двух рёбер), рёбра собираются на лету
+    static bool findSelfIntersection(const point* v, size_t n, bool closed, int& e1, int& e2) {
+        n = vertexCount(v, n, closed);
+        int count = int(n);
+        int m = edgeCount(n, closed);
+        if (m < 1) return false;
+
+        // 1. Вершины в лексикографическом порядке; совпадающие вершины - уже самопересечение
+        std::vector<int> order(n);
+        for (int i = 0; i < count; ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [v](int a, int b) {
+            return v[a] < v[b] || (v[a] == v[b] && a < b);
+            });
+        for (int k = 1; k < count; ++k) {
+            int u = order[k - 1];
+            int w = order[k];
+            if (v[u] == v[w]) {
+                if (w == u + 1) {
+                    e1 = e2 = u;                // ребро нулевой длины
+                }
+                else if (closed && u == 0 && w == count - 1) {
+                    e1 = e2 = count - 1;        // замыкающее ребро нулевой длины
+                }
+                else {
+                    e1 = std::min(u, w - 1);    // ребро из u и ребро в w касаются в одной точке
+                    e2 = std::max(u, w - 1);
+                }
+                return true;
+            }
+        }
+
+        // 2. Статус заметающей прямой строит прямые рёбер по вершинам при каждом сравнении:
+        // массив LineCoeffs (48 байт на ребро) был бы больше самого контура
+        double scale = 1.0;
+        for (size_t i = 0; i < n; ++i) {
+            scale = std::max({ scale, std::abs(v[i].x), std::abs(v[i].y) });
+        }
+        SweepStatusT<EdgeLines> active_edges(EdgeLines{ v, n }, 1e-9 * scale);
+
+        // 3. Проход по вершинам: сначала удаляются заканчивающиеся в вершине рёбра, затем вставляются
+        // начинающиеся. Их касание в общей вершине допустимо, поэтому держать их в дереве одновременно
+        // не нужно, и дерево не видит двух разных порядков "до" и "после" одной точки
+        for (int k = 0; k < count; ++k) {
+            int w = order[k];
+            active_edges.moveTo(v[w].x, v[w].y);
+
+            int incident[2] = { w > 0 ? w - 1 : (closed ? m - 1 : -1), w < m ? w : -1 };
+            for (int e : incident) {
+                if (e < 0 || startsAt(v, n, e, w)) continue;
+
+                int below, above;
+                if (active_edges.belowEnding(e, below) && active_edges.aboveEnding(e, above) &&
+                    edgesIntersect(v, n, closed, below, above)) {
+                    return found(below, above, e1, e2);
+                }
+                active_edges.erase(e);
+            }
+            for (int e : incident) {
+                if (e < 0 || !startsAt(v, n, e, w)) continue;
+                active_edges.insert(e);
+
+                int below, above;
+                if (active_edges.below(e, below) && edgesIntersect(v, n, closed, below, e)) {
+                    return found(below, e, e1, e2);
+                }
+                if (active_edges.above(e, above) && edgesIntersect(v, n, closed, e, above)) {
+                    return found(e, above, e1, e2);
+                }
+            }
+        }
+
+        return false;
+    }
+
+    // Перебор всех пар рёбер за O(n^2)
+    static bool findSelfIntersectionNaive(const point* v, size_t n, bool closed, int& e1, int& e2) {
+        n = vertexCount(v, n, closed);
+        int m = edgeCount(n, closed);
+
+        for (int i = 0; i < m; ++i) {
+            if (v[i] == v[(i + 1) % n]) {
+                return found(i, i, e1, e2);
+            }
+        }
+        for (int i = 0; i < m - 1; ++i) {
+            for (int j = i + 1; j < m; ++j) {
+                if (edgesIntersect(v, n, closed, i, j)) {
+                    return found(i, j, e1, e2);
+                }
+            }
+        }
+        return false;
+    }
+
+private:
+    // Прямые рёбер контура, построенные по его вершинам (источник прямых для SweepStatusT)
+    struct EdgeLines {
+        const point* v;
+        size_t n;
+
+        LineCoeffs operator()(int e) const {
+            const point& a = v[e];
+            const point& b = v[size_t(e) + 1 < n ? e + 1 : 0];
+            return LineCoeffs::fromEnds(a.x, a.y, b.x, b.y);
+        }
+    };
+
+    static size_t vertexCount(const point* v, size_t n, bool closed) {
+        return closed && n > 1 && v[0] == v[n - 1] ? n - 1 : n;
+    }
+
+    static int edgeCount(size_t n, bool closed) {
+        if (n < 2) return 0;
+        return closed ? int(n) : int(n) - 1;
+    }
+
+    // Ребро e начинается (является левым концом) в вершине w
+    static bool startsAt(const point* v, size_t n, int e, int w) {
+        int other = e == w ? (e + 1) % int(n) : e;
+        return v[w] < v[other];
+    }
+
+    // Нарушают ли рёбра a и b простоту ломаной
+    static bool edgesIntersect(const point* v, size_t n, bool closed, int a, int b) {
+        if (a == b) return false;
+        int m = edgeCount(n, closed);
+        if (a > b) std::swap(a, b);
+
+        // Соседние рёбра: плохо, только если они налегают друг на друга (ломаная разворачивается назад)
+        int shared = -1;
+        if (b == a + 1) shared = b;
+        else if (closed && a == 0 && b == m - 1) shared = 0;
+        if (shared >= 0) {
+            const point& s = v[shared % n];
+            const point& pa = v[shared == b ? a : 1];
+            const point& pb = v[shared == b ? (b + 1) % n : b];
+            return SetSection::side(s, pa, pb) == 0 &&
+                (SetSection::on_section(s, pa, pb) || SetSection::on_section(s, pb, pa));
+        }
+
+        section A{ v[a], v[(a + 1) % n] };
+        section B{ v[b], v[(b + 1) % n] };
+        return SetSection::intersection(A, B);
+    }
+
+    static bool found(int a, int b, int& e1, int& e2) {
+        e1 = std::min(a, b);
+        e2 = std::max(a, b);
+        return true;
+    }
+};
+
+#endif // OTREZKI_POLYLINE_H
@@ -0,0 +1,209 @@
+#ifndef OTREZKI_RADIX_SORT_H
+#define OTREZKI_RADIX_SORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+// Поразрядная сортировка пар "ключ - значение" по беззнаковому целому ключу, устойчивая: равные ключи
+// сохраняют исходный порядок. Байты, одинаковые у всех ключей, не сортируются.
+// Массив, который помещается в кэш, сортируется проходами по 8 бит от младшего байта к старшему (LSD).
+// Большой массив сначала раскладывается по старшему различающемуся байту (MSD): раскладка по всем
+// байтам сразу упирается в промахи кэша, а корзины первого прохода помещаются в кэш и досортировываются
+// так же, по отдельности. При threads > 1 массив делится на равные непрерывные части: поток считает
+// гистограмму своей части, смещения раздаются в порядке (байт, поток), и каждый поток раскладывает свою
+// часть сам; затем потоки разбирают корзины. Результат совпадает с последовательной сортировкой
+// при любом числе потоков
+class RadixSort {
+    static const int RADIX = 256;
+    static const size_t CACHE_ITEMS = size_t(1) << 15;   // столько пар раскладывается в пределах кэша L2
+
+public:
+    // Ключ double, порядок которого как целого без знака совпадает с порядком чисел: у неотрицательных
+    // взводится знаковый бит, у отрицательных инвертируются все биты. -0.0 даёт тот же ключ, что +0.0
+    // (они равны и для operator<), любой NaN - один и тот же ключ больше +inf: NaN идут последними
+    // и равны между собой, тогда как сортировка сравнением на NaN не определена
+    static uint64_t orderedKey(double value) {
+        if (value == 0) value = 0;
+        if (value != value) return ~uint64_t(0);
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        const uint64_t sign = uint64_t(1) << 63;
+        return bits & sign ? ~bits : bits | sign;
+    }
+
+    template <typename Key, typename Value>
+    static void sortPairs(std::vector<Key>& keys, std::vector<Value>& values, int threads = 1) {
+        std::vector<Key> keys_buffer;
+        std::vector<Value> values_buffer;
+        sortPairs(keys, values, keys_buffer, values_buffer, threads);
+    }
+
+    // То же с рабочими буферами вызывающего кода: если их ёмкости хватает, в одном потоке
+    // сортировка не обращается к куче
+    template <typename Key, typename Value>
+    static void sortPairs(std::vector<Key>& keys, std::vector<Value>& values,
+        std::vector<Key>& keys_buffer, std::vector<Value>& values_buffer, int threads = 1) {
+        size_t n = keys.size();
+        if (n < 2) return;
+        if (threads < 1) threads = 1;
+        if (n < size_t(threads) * 16384) threads = 1;   // потоки не окупаются на малых массивах
+
+        int top = topShift(keys.data(), n);
+        if (top < 0) return;
+        keys_buffer.resize(n);
+        values_buffer.resize(n);
+        if (n <= CACHE_ITEMS) {
+            sortRange(keys.data(), values.data(), keys_buffer.data(), values_buffer.data(), n, top + 8);
+            return;
+        }
+
+        // 1. Раскладка по старшему байту в буфер: гистограммы по частям, смещения сначала по байту,
+        // внутри байта - по номеру части
+        size_t single_offsets[RADIX];
+        std::vector<size_t> thread_offsets(threads > 1 ? size_t(threads) * RADIX : 0);
+        size_t* offsets = threads > 1 ? thread_offsets.data() : single_offsets;
+        size_t part = (n + threads - 1) / threads;
+        forEachPart(threads, [&](int t) {
+            size_t* count = &offsets[size_t(t) * RADIX];
+            std::fill(count, count + RADIX, 0);
+            for (size_t i = t * part, end = std::min(n, (t + 1) * part); i < end; ++i) {
+                ++count[(keys[i] >> top) & (RADIX - 1)];
+            }
+            });
+        size_t bucket_begin[RADIX + 1];
+        size_t total = 0;
+        for (int digit = 0; digit < RADIX; ++digit) {
+            bucket_begin[digit] = total;
+            for (int t = 0; t < threads; ++t) {
+                size_t count = offsets[size_t(t) * RADIX + digit];
+                offsets[size_t(t) * RADIX + digit] = total;
+                total += count;
+            }
+        }
+        bucket_begin[RADIX] = total;
+        forEachPart(threads, [&](int t) {
+            size_t* next = &offsets[size_t(t) * RADIX];
+            for (size_t i = t * part, end = std::min(n, (t + 1) * part); i < end; ++i) {
+                size_t to = next[(keys[i] >> top) & (RADIX - 1)]++;
+                keys_buffer[to] = keys[i];
+                values_buffer[to] = values[i];
+            }
+            });
+
+        // 2. Корзины досортировываются по младшим байтам и возвращаются на место; какой поток взял
+        // корзину, на результат не влияет
+        std::atomic<int> next_digit(0);
+        forEachPart(threads, [&](int) {
+            for (int digit; (digit = next_digit++) < RADIX;) {
+                size_t begin = bucket_begin[digit];
+                size_t count = bucket_begin[digit + 1] - begin;
+                if (count == 0) continue;
+                sortRange(&keys_buffer[begin], &values_buffer[begin], &keys[begin], &values[begin], count, top);
+                std::copy(&keys_buffer[begin], &keys_buffer[begin] + count, &keys[begin]);
+                std::copy(&values_buffer[begin], &values_buffer[begin] + count, &values[begin]);
+            }
+            });
+    }
+
+    // work(t) для t = 0..threads-1: нулевая часть - в вызывающем потоке, остальные - в своих
+    template <typename Work>
+    static void forEachPart(int threads, Work work) {
+        std::vector<std::thread> workers;
+        for (int t = 1; t < threads; ++t) {
+            workers.emplace_back(work, t);
+        }
+        work(0);
+        for (std::thread& w : workers) {
+            w.join();
+        }
+    }
+
+private:
+    // Сдвиг старшего байта, в котором ключи различаются; -1, если все ключи равны
+    template <typename Key>
+    static int topShift(const Key* keys, size_t n) {
+        Key diff = 0;
+        for (size_t i = 1; i < n; ++i) {
+            diff |= keys[i] ^ keys[0];
+        }
+        if (diff == 0) return -1;
+        int shift = 0;
+        while (diff >> 8) {
+            diff >>= 8;
+            shift += 8;
+        }
+        return shift;
+    }
+
+    // Сортировка keys[0..n) по младшим bits битам ключа; результат остаётся в keys, буферы - рабочие.
+    // Диапазон больше кэша снова раскладывается по старшему различающемуся байту
+    template <typename Key, typename Value>
+    static void sortRange(Key* keys, Value* values, Key* keys_buffer, Value* values_buffer, size_t n, int bits) {
+        size_t count[RADIX];
+        if (n > CACHE_ITEMS && bits > 8) {
+            int top = topShift(keys, n);
+            if (top < 0) return;
+            std::fill(count, count + RADIX, 0);
+            for (size_t i = 0; i < n; ++i) {
+                ++count[(keys[i] >> top) & (RADIX - 1)];
+            }
+            size_t begin[RADIX];
+            size_t next[RADIX];
+            for (size_t digit = 0, total = 0; digit < RADIX; total += count[digit++]) {
+                begin[digit] = next[digit] = total;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                size_t to = next[(keys[i] >> top) & (RADIX - 1)]++;
+                keys_buffer[to] = keys[i];
+                values_buffer[to] = values[i];
+            }
+            for (int digit = 0; digit < RADIX; ++digit) {
+                size_t b = begin[digit];
+                if (count[digit] == 0) continue;
+                sortRange(keys_buffer + b, values_buffer + b, keys + b, values + b, count[digit], top);
+                std::copy(keys_buffer + b, keys_buffer + b + count[digit], keys + b);
+                std::copy(values_buffer + b, values_buffer + b + count[digit], values + b);
+            }
+            return;
+        }
+
+        Key* from_keys = keys;
+        Value* from_values = values;
+        Key* to_keys = keys_buffer;
+        Value* to_values = values_buffer;
+        for (int shift = 0; shift < bits; shift += 8) {
+            std::fill(count, count + RADIX, 0);
+            for (size_t i = 0; i < n; ++i) {
+                ++count[(from_keys[i] >> shift) & (RADIX - 1)];
+            }
+            size_t total = 0;
+            bool trivial = false;
+            for (int digit = 0; digit < RADIX; ++digit) {
+                size_t c = count[digit];
+                count[digit] = total;
+                trivial = trivial || c == n;
+                total += c;
+            }
+            if (trivial) continue;
+
+            for (size_t i = 0; i < n; ++i) {
+                size_t to = count[(from_keys[i] >> shift) & (RADIX - 1)]++;
+                to_keys[to] = from_keys[i];
+                to_values[to] = from_values[i];
+            }
+            std::swap(from_keys, to_keys);
+            std::swap(from_values, to_values);
+        }
+        if (from_keys != keys) {
+            std::copy(from_keys, from_keys + n, keys);
+            std::copy(from_values, from_values + n, values);
+        }
+    }
+};
+
+#endif // OTREZKI_RADIX_SORT_H
@@ -0,0 +1,91 @@
+#ifndef OTREZKI_RANK_SET_H
+#define OTREZKI_RANK_SET_H
+
+#include <vector>
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Множество целых рангов [0, n) на иерархии битовых масок: уровень 0 - сами ранги,
+// бит уровня l+1 отмечает непустое слово уровня l. Вставка, удаление и поиск следующего
+// элемента работают за O(log_64 n) - для любых реальных n это 3-4 слова
+class RankSet {
+    std::vector<std::vector<uint64_t>> levels;   // используются первые depth уровней, остальные - запас от reset
+    size_t depth = 0;
+
+    static int lowestBit(uint64_t word) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return int(index);
+#else
+        return __builtin_ctzll(word);
+#endif
+    }
+
+public:
+    // Пустое множество без памяти; перед использованием - reset
+    RankSet() = default;
+
+    explicit RankSet(int n) {
+        reset(n);
+    }
+
+    // Пустое множество рангов [0, n). Память уровней остаётся от прошлых reset: если её хватает,
+    // повторная разметка не обращается к куче
+    void reset(int n) {
+        depth = 0;
+        do {
+            int words = (n + 63) / 64;
+            if (depth == levels.size()) levels.emplace_back();
+            levels[depth++].assign(words > 0 ? words : 1, 0);
+            n = words;
+        } while (n > 1);
+    }
+
+    void insert(int r) {
+        for (size_t l = 0; l < depth; ++l) {
+            uint64_t& word = levels[l][r >> 6];
+            bool was_empty = word == 0;
+            word |= uint64_t(1) << (r & 63);
+            if (!was_empty) break;
+            r >>= 6;
+        }
+    }
+
+    void erase(int r) {
+        for (size_t l = 0; l < depth; ++l) {
+            uint64_t& word = levels[l][r >> 6];
+            word &= ~(uint64_t(1) << (r & 63));
+            if (word != 0) break;
+            r >>= 6;
+        }
+    }
+
+    // Наименьший элемент, не меньший r; -1, если такого нет
+    int next(int r) const {
+        // Поднимаемся, пока в текущем слове нет элементов не меньше r
+        size_t l = 0;
+        for (; l < depth; ++l) {
+            size_t index = size_t(r) >> 6;
+            if (index >= levels[l].size()) return -1;
+            uint64_t word = levels[l][index] & (~uint64_t(0) << (r & 63));
+            if (word != 0) {
+                r = int(index << 6) + lowestBit(word);
+                break;
+            }
+            r = int(index) + 1;
+        }
+        if (l == depth) return -1;
+
+        // Спускаемся к самому левому элементу под найденным битом
+        while (l > 0) {
+            --l;
+            r = (r << 6) + lowestBit(levels[l][r]);
+        }
+        return r;
+    }
+};
+
+#endif // OTREZKI_RANK_SET_H
@@ -0,0 +1,117 @@
+#ifndef OTREZKI_ROBUST_PREDICATES_H
+#define OTREZKI_ROBUST_PREDICATES_H
+
+#include <cmath>
+#include <limits>
+
+// Знаки векторных произведений по координатам double без ошибок округления (адаптивная схема Шевчука).
+// Сначала произведение считается обычным образом и сравнивается с гарантированной оценкой погрешности;
+// лишь если знак по ней не определён (почти коллинеарные точки), оно пересчитывается точно - суммой
+// неперекрывающихся компонент (expansion), где каждая разность и произведение разложены без потерь.
+// На данных общего положения точный пересчёт не выполняется, и предикат стоит как обычный det
+class RobustPredicates {
+public:
+    // Знак (bx-ax)*(dy-cy) - (by-ay)*(dx-cx): векторное произведение направлений AB и CD
+    static int cross(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy) {
+        double left = (bx - ax) * (dy - cy);
+        double right = (by - ay) * (dx - cx);
+        double det = left - right;
+        double bound = errorBound() * (std::abs(left) + std::abs(right));
+        if (det > bound) return 1;
+        if (-det > bound) return -1;
+        return crossExact(ax, ay, bx, by, cx, cy, dx, dy);
+    }
+
+    // Знак (B-A)x(C-A): 1 - C слева от AB, -1 - справа, 0 - на прямой AB
+    static int orient(double ax, double ay, double bx, double by, double cx, double cy) {
+        return cross(ax, ay, bx, by, ax, ay, cx, cy);
+    }
+
+    // Тот же знак, но всегда через точную сумму (для проверки фильтра)
+    static int crossExact(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy) {
+        double u[2], v[2], p[2], q[2];
+        twoDiff(bx, ax, u[1], u[0]);
+        twoDiff(dy, cy, v[1], v[0]);
+        twoDiff(by, ay, p[1], p[0]);
+        twoDiff(dx, cx, q[1], q[0]);
+
+        // u*v - p*q: восемь точных произведений по компонентам, каждое - ещё две компоненты
+        double sum[16];
+        int n = 0;
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 2; ++j) {
+                double hi, lo;
+                twoProduct(u[i], v[j], hi, lo);
+                n = grow(sum, n, lo);
+                n = grow(sum, n, hi);
+                twoProduct(-p[i], q[j], hi, lo);
+                n = grow(sum, n, lo);
+                n = grow(sum, n, hi);
+            }
+        }
+        // Компоненты возрастают по модулю: знак суммы - знак старшей ненулевой
+        for (int k = n - 1; k >= 0; --k) {
+            if (sum[k] > 0) return 1;
+            if (sum[k] < 0) return -1;
+        }
+        return 0;
+    }
+
+private:
+    // (3 + 16u)u, u = 2^-53: оценка Шевчука для det = l - r, где l и r - произведения разностей
+    static double errorBound() {
+        const double u = std::numeric_limits<double>::epsilon() / 2;
+        return (3.0 + 16.0 * u) * u;
+    }
+
+    // a - b = x + y точно, x = fl(a - b)
+    static void twoDiff(double a, double b, double& x, double& y) {
+        x = a - b;
+        double bv = a - x;
+        double av = x + bv;
+        y = (a - av) + (bv - b);
+    }
+
+    static void twoSum(double a, double b, double& x, double& y) {
+        x = a + b;
+        double bv = x - a;
+        double av = x - bv;
+        y = (a - av) + (b - bv);
+    }
+
+    // a * b = x + y точно. С аппаратным FMA младшая часть - fma(a, b, -x); без него - расщепление
+    // Деккера (там же компилятор не может слить умножение со сложением и испортить разложение)
+    static void twoProduct(double a, double b, double& x, double& y) {
+        x = a * b;
+#ifdef FP_FAST_FMA
+        y = std::fma(a, b, -x);
+#else
+        double ah, al, bh, bl;
+        split(a, ah, al);
+        split(b, bh, bl);
+        y = al * bl - (((x - ah * bh) - al * bh) - ah * bl);
+#endif
+    }
+
+    static void split(double a, double& hi, double& lo) {
+        double c = 134217729.0 * a;   // 2^27 + 1
+        double big = c - a;
+        hi = c - big;
+        lo = a - hi;
+    }
+
+    // Добавление b к сумме e[0..n) с сохранением неперекрываемости (Grow-Expansion); нули не хранятся
+    static int grow(double* e, int n, double b) {
+        int m = 0;
+        double q = b;
+        for (int i = 0; i < n; ++i) {
+            double h;
+            twoSum(q, e[i], q, h);
+            if (h != 0) e[m++] = h;
+        }
+        if (q != 0) e[m++] = q;
+        return m;
+    }
+};
+
+#endif // OTREZKI_ROBUST_PREDICATES_H
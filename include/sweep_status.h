@@ -0,0 +1,282 @@
+#ifndef OTREZKI_SWEEP_STATUS_H
+#define OTREZKI_SWEEP_STATUS_H
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include "avl_tree.h"
+#include "wide_int.h"
+#include "robust_predicates.h"
+
+// Прямая, на которой лежит отрезок: y = k*x + b (коэффициенты считаются один раз на отрезок)
+struct LineCoeffs {
+    double k;       // Наклон; бесконечность для вертикального отрезка
+    double b;       // Свободный член
+    double y_min;   // y левого и правого концов; у вертикального - диапазон y
+    double y_max;
+    double x_min;   // x левого и правого концов - для точного сравнения наклонов
+    double x_max;
+
+    bool vertical() const {
+        return k == std::numeric_limits<double>::infinity();
+    }
+
+    // y на прямой x; вертикальный отрезок "находится" в ближайшей к y0 своей точке
+    double y_at(double x, double y0) const {
+        if (vertical()) return std::min(std::max(y0, y_min), y_max);
+#ifdef FP_FAST_FMA
+        return std::fma(k, x, b);
+#else
+        return k * x + b;   // при -mfma компилятор сам сводит это к одному FMA
+#endif
+    }
+
+    static LineCoeffs fromEnds(double x1, double y1, double x2, double y2) {
+        if (x2 < x1 || (x2 == x1 && y2 < y1)) {
+            std::swap(x1, x2);
+            std::swap(y1, y2);
+        }
+        if (x1 == x2) {
+            return { std::numeric_limits<double>::infinity(), 0.0, y1, y2, x1, x2 };
+        }
+        double k = (y2 - y1) / (x2 - x1);
+        return { k, y1 - k * x1, y1, y2, x1, x2 };
+    }
+};
+
+// Отрезок с целыми концами для точного порядка на заметающей прямой: левый (для вертикального -
+// нижний) конец первым. Координаты int32 расширены до int64, чтобы разности не переполнялись
+struct ExactLine {
+    int64_t x0, y0, x1, y1;
+
+    bool vertical() const {
+        return x0 == x1;
+    }
+
+    static ExactLine fromEnds(int64_t x1, int64_t y1, int64_t x2, int64_t y2) {
+        if (x2 < x1 || (x2 == x1 && y2 < y1)) {
+            std::swap(x1, x2);
+            std::swap(y1, y2);
+        }
+        return { x1, y1, x2, y2 };
+    }
+};
+
+// Коэффициенты прямых массивом, по элементу на отрезок
+struct LineArray {
+    const LineCoeffs* lines;
+
+    const LineCoeffs& operator()(int id) const {
+        return lines[id];
+    }
+};
+
+// Положение заметающей прямой (точка события x, y) и порядок отрезков на ней.
+// Отрезки сравниваются по y на прямой x; совпадение y возможно только в самой точке события,
+// там отрезки упорядочены по наклону сразу после неё (after) или так, как они уже стоят
+// в дереве (!after, позиции rank; без rank - по наклону сразу до точки). Наклоны сравниваются
+// не по округлённым k, а знаком векторного произведения направлений (RobustPredicates).
+// Если заданы exact (целые концы, события в целых точках), y и наклоны сравниваются точно
+// дробями в 128 битах, eps не используется.
+// Lines(id) выдаёт прямую отрезка id: из массива (LineArray) или построенную по концам в момент
+// сравнения, если массив LineCoeffs на каждый отрезок обошёлся бы дороже самих данных
+template <typename Lines>
+struct SweepLineT {
+    enum { PROBE = -1 };    // Индекс-заглушка, обозначающий саму точку события
+
+    Lines lines;
+    double x;
+    double y;
+    bool after;
+    double eps;
+    const int* rank;
+    const ExactLine* exact;
+
+    double yAt(int id) const {
+        return id == PROBE ? y : lines(id).y_at(x, y);
+    }
+
+    bool near(double px, double py) const {
+        return std::abs(px - x) <= eps && std::abs(py - y) <= eps;
+    }
+
+    bool less(int a, int b) const {
+        if (a == b) return false;
+        if (exact) return lessExact(a, b);
+        double ya = yAt(a);
+        double yb = yAt(b);
+        if (ya < yb - eps) return true;
+        if (yb < ya - eps) return false;
+        if (a == PROBE || b == PROBE) return false;
+        return tieLess(a, b);
+    }
+
+    // Порядок отрезков с равными y в точке события
+    bool tieLess(int a, int b) const {
+        int slope = slopeCompare(a, b);
+        if (!after) {
+            if (rank) return rank[a] < rank[b];
+            if (slope != 0) return slope > 0;
+        }
+        else if (slope != 0) {
+            return slope < 0;
+        }
+        return a < b;
+    }
+
+    // Знак ka - kb; вертикальный отрезок круче любого другого
+    int slopeCompare(int a, int b) const {
+        if (exact) return slopeCompareExact(a, b);
+        const LineCoeffs& la = lines(a);
+        const LineCoeffs& lb = lines(b);
+        if (la.vertical() || lb.vertical()) return int(la.vertical()) - int(lb.vertical());
+        return RobustPredicates::cross(lb.x_min, lb.y_min, lb.x_max, lb.y_max, la.x_min, la.y_min, la.x_max, la.y_max);
+    }
+
+    // y отрезка id на прямой x дробью num / den, den > 0
+    void exactY(int id, wide_int& num, int64_t& den) const {
+        int64_t px = int64_t(x);
+        int64_t py = int64_t(y);
+        den = 1;
+        if (id == PROBE) {
+            num = py;
+            return;
+        }
+        const ExactLine& s = exact[id];
+        if (s.vertical()) {
+            num = std::min(std::max(py, s.y0), s.y1);
+            return;
+        }
+        den = s.x1 - s.x0;
+        num = wide_int(s.y0) * den + wide_int(s.y1 - s.y0) * (px - s.x0);
+    }
+
+    int slopeCompareExact(int a, int b) const {
+        const ExactLine& sa = exact[a];
+        const ExactLine& sb = exact[b];
+        if (sa.vertical() || sb.vertical()) return int(sa.vertical()) - int(sb.vertical());
+        return wideSign(wide_int(sa.y1 - sa.y0) * (sb.x1 - sb.x0) - wide_int(sb.y1 - sb.y0) * (sa.x1 - sa.x0));
+    }
+
+    bool lessExact(int a, int b) const {
+        wide_int na, nb;
+        int64_t da, db;
+        exactY(a, na, da);
+        exactY(b, nb, db);
+        int cmp = wideSign(na * db - nb * da);
+        if (cmp != 0) return cmp < 0;
+        if (a == PROBE || b == PROBE) return false;
+        return tieLess(a, b);
+    }
+};
+
+typedef SweepLineT<LineArray> SweepLine;
+
+template <typename Lines>
+struct SweepOrderT {
+    const SweepLineT<Lines>* line;
+    bool operator()(int a, int b) const {
+        return line->less(a, b);
+    }
+};
+
+// Статус заметающей прямой: индексы активных отрезков в АВЛ-дереве, упорядоченные
+// по y на текущей прямой. Порядок пересчитывается на лету, поэтому не "замерзает"
+// после вставки, как ключ y, вычисленный один раз. С exact порядок точный (см. SweepLine).
+template <typename Lines>
+class SweepStatusT {
+    typedef SweepLineT<Lines> Line;
+
+    Line line;
+    AVLTree<int, int, SweepOrderT<Lines>> tree;
+
+public:
+    explicit SweepStatusT(const std::vector<LineCoeffs>& lines, double eps = 1e-9, const ExactLine* exact = nullptr)
+        : line{ { lines.data() }, 0.0, 0.0, true, exact ? 0.0 : eps, nullptr, exact }, tree(SweepOrderT<Lines>{ &line }) {}
+
+    // Прямые из источника lines (например, строятся по вершинам контура при каждом сравнении)
+    explicit SweepStatusT(Lines lines, double eps = 1e-9)
+        : line{ lines, 0.0, 0.0, true, eps, nullptr, nullptr }, tree(SweepOrderT<Lines>{ &line }) {}
+
+    // Пустой статус для рабочей памяти (SweepWorkspace); перед проходом - reset
+    SweepStatusT() : line{ Lines(), 0.0, 0.0, true, 0.0, nullptr, nullptr }, tree(SweepOrderT<Lines>{ &line }) {}
+
+    SweepStatusT(const SweepStatusT&) = delete;
+    SweepStatusT& operator=(const SweepStatusT&) = delete;
+
+    // Новый проход по другим прямым: дерево опустошается, но его узлы остаются для следующих вставок
+    void reset(const std::vector<LineCoeffs>& lines, double eps = 1e-9, const ExactLine* exact = nullptr) {
+        tree.clear();
+        line = Line{ { lines.data() }, 0.0, 0.0, true, exact ? 0.0 : eps, nullptr, exact };
+    }
+
+    // Переход к следующему событию
+    void moveTo(double x, double y) {
+        line.x = x;
+        line.y = y;
+    }
+
+    // Позиции отрезков, проходящих через точку события, в дереве до её обработки
+    void setRank(const int* rank) {
+        line.rank = rank;
+    }
+
+    // Вставка идёт в порядке "после" точки события, удаление - в порядке "до" неё
+    void insert(int id) {
+        line.after = true;
+        tree.insert(id, id);
+    }
+
+    void erase(int id) {
+        line.after = false;
+        tree.erase(id);
+        line.after = true;
+    }
+
+    // Соседи снизу и сверху; id может быть SweepLine::PROBE - тогда соседи самой точки события
+    bool below(int id, int& pred) const {
+        int key;
+        return tree.predecessor(id, key, pred);
+    }
+
+    bool above(int id, int& succ) const {
+        int key;
+        return tree.successor(id, key, succ);
+    }
+
+    // Соседи отрезка, который заканчивается в точке события, - в порядке "до" неё
+    // (в порядке "после" касающиеся в этой точке отрезки уже переставлены по наклону)
+    bool belowEnding(int id, int& pred) {
+        line.after = false;
+        bool found = below(id, pred);
+        line.after = true;
+        return found;
+    }
+
+    bool aboveEnding(int id, int& succ) {
+        line.after = false;
+        bool found = above(id, succ);
+        line.after = true;
+        return found;
+    }
+
+    // Активные отрезки, проходящие через точку события, снизу вверх
+    void through(std::vector<int>& ids) const {
+        tree.findAll(Line::PROBE, ids);
+    }
+
+    const Line& position() const {
+        return line;
+    }
+
+    int size() const {
+        return tree.size();
+    }
+};
+
+typedef SweepOrderT<LineArray> SweepOrder;
+typedef SweepStatusT<LineArray> SweepStatus;
+
+#endif // OTREZKI_SWEEP_STATUS_H
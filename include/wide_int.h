@@ -0,0 +1,80 @@
+#ifndef OTREZKI_WIDE_INT_H
+#define OTREZKI_WIDE_INT_H
+
+#include <cstdint>
+
+// Знаковое 128-битное целое в дополнительном коде для точных предикатов над целыми координатами.
+// Сложение, вычитание и умножение берутся по модулю 2^128, поэтому результат верен всегда,
+// когда точное значение помещается в 128 бит. Используется там, где нет встроенного __int128 (MSVC)
+class Int128 {
+    uint64_t lo;
+    uint64_t hi;
+
+    // Старшие 64 бита произведения a*b через 32-битные половины
+    static uint64_t mulHigh(uint64_t a, uint64_t b) {
+        uint64_t a_lo = a & 0xFFFFFFFFu, a_hi = a >> 32;
+        uint64_t b_lo = b & 0xFFFFFFFFu, b_hi = b >> 32;
+        uint64_t low = a_lo * b_lo;
+        uint64_t mid1 = a_hi * b_lo + (low >> 32);
+        uint64_t mid2 = a_lo * b_hi + (mid1 & 0xFFFFFFFFu);
+        return a_hi * b_hi + (mid1 >> 32) + (mid2 >> 32);
+    }
+
+public:
+    Int128(int64_t value = 0) : lo(uint64_t(value)), hi(value < 0 ? ~uint64_t(0) : 0) {}
+
+    Int128 operator-() const {
+        Int128 r;
+        r.lo = ~lo + 1;
+        r.hi = ~hi + (r.lo == 0);
+        return r;
+    }
+
+    friend Int128 operator+(const Int128& a, const Int128& b) {
+        Int128 r;
+        r.lo = a.lo + b.lo;
+        r.hi = a.hi + b.hi + (r.lo < a.lo);
+        return r;
+    }
+
+    friend Int128 operator-(const Int128& a, const Int128& b) {
+        return a + -b;
+    }
+
+    friend Int128 operator*(const Int128& a, const Int128& b) {
+        Int128 r;
+        r.lo = a.lo * b.lo;
+        r.hi = mulHigh(a.lo, b.lo) + a.lo * b.hi + a.hi * b.lo;
+        return r;
+    }
+
+    friend bool operator<(const Int128& a, const Int128& b) {
+        return int64_t(a.hi) < int64_t(b.hi) || (a.hi == b.hi && a.lo < b.lo);
+    }
+
+    friend bool operator>(const Int128& a, const Int128& b) {
+        return b < a;
+    }
+
+    friend bool operator==(const Int128& a, const Int128& b) {
+        return a.lo == b.lo && a.hi == b.hi;
+    }
+
+    friend bool operator!=(const Int128& a, const Int128& b) {
+        return !(a == b);
+    }
+};
+
+#if defined(__SIZEOF_INT128__)
+typedef __int128 wide_int;
+#else
+typedef Int128 wide_int;
+#endif
+
+// Знак числа: 1, 0 или -1
+template <typename W>
+int wideSign(const W& value) {
+    return (W(0) < value) - (value < W(0));
+}
+
+#endif // OTREZKI_WIDE_INT_H
@@ -24,106 +24,6 @@ double measureTime(Func func) {
     return duration_cast<duration<double>>(end - start).count();    //Вычисляем разницу времени
 }
 
-// Вспомогательная функция для обработки событий в эффективном алгоритме
-// Содержит основную логику работы с AVL-деревом для поиска пересечений
-bool processEvents(const SetSection& set, const vector<Event>& events, section& s1, section& s2) {
-    AVLTree<double, int> active_segments;   // Дерево для хранения активных отрезков
-    double current_x = 0;                   // Координата заметающей прямой
-
-    // Обработка уже отсортированных событий(проход слева направо)
-    for (const auto& event : events) {
-        current_x = event.p.x;              // Обновляем текущую x-координату
-        int seg_id = event.segment_index;   // Получаем индекс обрабатываемого отрезка
-        const section& current_seg = set.getSection(seg_id);    // Получаем сам отрезок
-
-        if (event.is_left) {
-            // Левый конец - вставка отрезка
-            double y_key = set.get_y_at_x(current_seg, current_x);
-            active_segments.insert(y_key, seg_id);
-
-            // Поиск соседей и проверка пересечений
-            try {
-                // Поиск предшественника
-                double pred_key;
-                int pred_id = -1;
-                if (active_segments.predecessor(y_key, pred_key, pred_id)) {
-                    if (set.intersection(set.getSection(pred_id), current_seg)) {
-                        s1 = set.getSection(pred_id);
-                        s2 = current_seg;
-                        return true;
-                    }
-                }
-
-                // Поиск преемника
-                double succ_key;
-                int succ_id = -1;
-                if (active_segments.successor(y_key, succ_key, succ_id)) {
-                    if (set.intersection(set.getSection(succ_id), current_seg)) {
-                        s1 = set.getSection(succ_id);
-                        s2 = current_seg;
-                        return true;
-                    }
-                }
-            }
-            catch (...) {
-                // Игнорируем ошибки
-            }
-
-        }
-        else {
-            // Удаление отрезка
-            double y_key = set.get_y_at_x(current_seg, current_x);
-
-            // Поиск соседей перед удалением
-            try {
-                double pred_key, succ_key;
-                int pred_id = -1, succ_id = -1;
-
-                bool has_pred = active_segments.predecessor(y_key, pred_key, pred_id);
-                bool has_succ = active_segments.successor(y_key, succ_key, succ_id);
-
-                // Проверка пересечения между соседями
-                if (has_pred && has_succ &&
-                    set.intersection(set.getSection(pred_id), set.getSection(succ_id))) {
-                    s1 = set.getSection(pred_id);
-                    s2 = set.getSection(succ_id);
-                    return true;
-                }
-            }
-            catch (...) {
-                // Игнорируем ошибки
-            }
-
-            // Удаляем отрезок из дерева
-            try {
-                active_segments.erase(y_key);
-            }
-            catch (...) {
-                // Игнорируем ошибки удаления
-            }
-        }
-    }
-
-    return false;
-}
-
-// Функция для подготовки событий (вынесена для переиспользования)
-// Создает и сортирует массив событий для алгоритма заметающей прямой
-void prepareEvents(const SetSection& set, vector<Event>& events) {
-    events.clear();
-    for (int i = 0; i < set.size(); ++i) {
-        section seg = set.getSection(i);
-        point left = seg.begin;
-        point right = seg.end;
-        if (right < left) {
-            std::swap(left, right);
-        }
-        events.push_back({ left, i, true });
-        events.push_back({ right, i, false });
-    }
-    std::sort(events.begin(), events.end());
-}
-
 // Функция для измерения времени обоих алгоритмов
 void measureBothAlgorithms(SetSection& set, double& time_naive, double& time_effective) {
     section s1, s2;
@@ -133,13 +33,13 @@ void measureBothAlgorithms(SetSection& set, double& time_naive, double& time_eff
         set.intersectionNaive(s1, s2);
         });
 
-    // Подготовка событий для эффективного алгоритма
-    vector<Event> events;
-    prepareEvents(set, events);
+    // Подготовка событий для эффективного алгоритма (сортировка в кэше набора, не входит в измерение)
+    SweepWorkspace workspace;
+    set.prepare(workspace);
 
-    // Измерение времени эффективного алгоритма
+    // Измерение времени эффективного алгоритма: проход заметающей прямой библиотеки по готовым событиям
     time_effective = measureTime([&]() {
-        processEvents(set, events, s1, s2);
+        set.intersectionEffective(s1, s2, workspace);
         });
 }
 
@@ -227,6 +127,61 @@ void test3_4() {
     cout << "Результаты сохранены в test3_4.csv" << endl;
 }
 
+// Сравнение sweep-and-prune по x-интервалам (T3) с intersectionEffective (T2): оба ищут первую пару,
+// сортировка событий и отрезков входит во время
+void measurePruneAndEffective(SetSection& set, double& time_effective, double& time_prune) {
+    section s1, s2;
+    time_effective = measureTime([&]() {
+        set.intersectionEffective(s1, s2);
+        });
+    time_prune = measureTime([&]() {
+        set.intersectionPrune(s1, s2);
+        });
+}
+
+// Тест 3.3 для sweep-and-prune: r = 0.001, n = 1...10000 с шагом 100
+void test3_3_prune() {
+    cout << "Тест 3.3 (sweep-and-prune): r=0.001, n=1...10000, шаг 100" << endl;
+    ofstream file("test3_3_prune.csv");
+    file << "n,T2,T3" << endl;
+
+    double r = 0.001;
+    for (int n = 1; n <= 10000; n += 100) {
+        SetSection set;
+        set.generate_controlled_fixed_length_sections(n, n / 2, r);
+
+        double time_effective, time_prune;
+        measurePruneAndEffective(set, time_effective, time_prune);
+
+        file << n << "," << time_effective << "," << time_prune << endl;
+        cout << "n=" << n << " T2=" << time_effective << " T3=" << time_prune << endl;
+    }
+    file.close();
+    cout << "Результаты сохранены в test3_3_prune.csv" << endl;
+}
+
+// Тест 3.4 для sweep-and-prune: n = 10000, r = 0.0001...0.01 с шагом 0.0001
+void test3_4_prune() {
+    cout << "Тест 3.4 (sweep-and-prune): n=10000, r=0.0001...0.01, шаг 0.0001" << endl;
+    ofstream file("test3_4_prune.csv");
+    file << "r,T2,T3" << endl;
+
+    int n = 10000;
+    int k = 5000;
+    for (double r = 0.0001; r <= 0.01; r += 0.0001) {
+        SetSection set;
+        set.generate_controlled_fixed_length_sections(n, k, r);
+
+        double time_effective, time_prune;
+        measurePruneAndEffective(set, time_effective, time_prune);
+
+        file << r << "," << time_effective << "," << time_prune << endl;
+        cout << "r=" << r << " T2=" << time_effective << " T3=" << time_prune << endl;
+    }
+    file.close();
+    cout << "Результаты сохранены в test3_4_prune.csv" << endl;
+}
+
 int main() {
     setlocale(LC_ALL, "Russian");
     srand(time(0)); // Инициализация генератора случайных чисел
@@ -250,6 +205,8 @@ int main() {
         cout << "2. Тест 3.2: n=1000, k=1...1000, шаг 10" << endl;
         cout << "3. Тест 3.3: r=0.001, n=1...10000, шаг 100" << endl;
         cout << "4. Тест 3.4: n=10000, r=0.0001...0.01, шаг 0.0001" << endl;
+        cout << "5. Тест 3.3: sweep-and-prune против эффективного алгоритма" << endl;
+        cout << "6. Тест 3.4: sweep-and-prune против эффективного алгоритма" << endl;
         cout << "Ваш выбор: ";
         cin >> test_choice;
 
@@ -258,6 +215,8 @@ int main() {
         case 2: test3_2(); break;
         case 3: test3_3(); break;
         case 4: test3_4(); break;
+        case 5: test3_3_prune(); break;
+        case 6: test3_4_prune(); break;
         default: cout << "Неверный выбор теста" << endl;
         }
         return 0;
@@ -329,18 +288,18 @@ int main() {
         });
 
     // Подготовка событий для эффективного алгоритма (не входит в измерение времени)
-    vector<Event> events;
-    prepareEvents(set, events);
+    SweepWorkspace workspace;
+    set.prepare(workspace);
 
-    // Измерение времени только обработки в AVL-дереве (без копирования данных)
+    // Измерение времени только прохода заметающей прямой (без сортировки событий)
     section effective_s1, effective_s2;
     double time_effective = measureTime([&]() {
-        processEvents(set, events, effective_s1, effective_s2);
+        set.intersectionEffective(effective_s1, effective_s2, workspace);
         });
 
     cout << "\nРЕЗУЛЬТАТЫ ИЗМЕРЕНИЙ ВРЕМЕНИ:" << endl;
     cout << "Т1 (тривиальный алгоритм): " << time_naive << " секунд" << endl;
-    cout << "Т2 (нетривиальный алгоритм, только AVL-обработка): " << time_effective << " секунд" << endl;
+    cout << "Т2 (нетривиальный алгоритм, только проход заметающей прямой): " << time_effective << " секунд" << endl;
     cout << "Отношение Т1/Т2: " << (time_effective > 0 ? time_naive / time_effective : 0) << endl;
 
     // Проверка результатов
@@ -0,0 +1,39 @@
+#include "allocation_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Вне AllocationCounter operator new лишь выделяет память
+std::atomic<bool> counting(false);
+std::atomic<size_t> heap_allocations(0);
+
+}
+
+AllocationCounter::AllocationCounter() {
+    heap_allocations = 0;
+    counting = true;
+}
+
+AllocationCounter::~AllocationCounter() {
+    counting = false;
+}
+
+size_t AllocationCounter::count() const {
+    return heap_allocations;
+}
+
+void* operator new(size_t size) {
+    if (counting) ++heap_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
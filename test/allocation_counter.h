@@ -0,0 +1,19 @@
+#ifndef OTREZKI_ALLOCATION_COUNTER_H
+#define OTREZKI_ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+// Подсчёт вызовов operator new, пока объект жив. Замена operator new и delete - в allocation_counter.cpp,
+// отдельной единице трансляции: там компилятор не встраивает их в вызывающий код
+class AllocationCounter {
+public:
+    AllocationCounter();
+    ~AllocationCounter();
+
+    AllocationCounter(const AllocationCounter&) = delete;
+    AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+    size_t count() const;
+};
+
+#endif // OTREZKI_ALLOCATION_COUNTER_H
@@ -0,0 +1,42 @@
+#include "otrezki.h"
+#include "allocation_counter.h"
+#include <gtest.h>
+
+// Проверки обращений к куче. Они идут через замену глобальных operator new и delete (allocation_counter.cpp),
+// поэтому собраны в отдельный исполняемый файл: остальные тесты и сам gtest работают со стандартным
+// распределителем памяти
+
+TEST(SetSection, workspace_search_does_not_allocate) {
+    // Наборы без пересечений, чтобы каждый алгоритм прошёл их целиком: наклонные параллельные отрезки
+    // двух размеров и горизонтали с вертикалями
+    std::vector<SetSection> sets(3);
+    srand(26);
+    for (int i = 0; i < 4000; ++i) {
+        point a{ rand() / double(RAND_MAX), rand() / double(RAND_MAX) };
+        sets[i % 2].add_section(a, { a.x + 0.004, a.y + 0.001 });
+        a.y *= 0.5;
+        if (i % 2) sets[2].add_section({ a.x, a.y + 0.5 }, { a.x, a.y + 0.501 });
+        else sets[2].add_section(a, { a.x + 0.001, a.y });
+    }
+    sets[1].add_section({ 2, 2 }, { 3, 3 });
+
+    SweepWorkspace workspace;
+    std::vector<SearchEngine> engines = { ENGINE_NAIVE, ENGINE_SWEEP, ENGINE_GRID, ENGINE_PRUNE };
+    auto searchAll = [&](const SetSection& set) {
+        section s1, s2;
+        for (SearchEngine engine : engines) {
+            set.findIntersection(s1, s2, engine, workspace);
+        }
+        set.findIntersection(s1, s2, workspace);
+        if (set.isOrthogonal()) set.findIntersection(s1, s2, ENGINE_ORTHOGONAL, workspace);
+    };
+    for (const SetSection& set : sets) {
+        searchAll(set);
+    }
+
+    AllocationCounter counter;
+    for (const SetSection& set : sets) {
+        searchAll(set);
+    }
+    EXPECT_EQ(0u, counter.count());
+}
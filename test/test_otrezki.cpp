@@ -1,3 +1,1061 @@
 #include "otrezki.h"
 #include <gtest.h>
 
+namespace {
+
+std::vector<std::pair<int, int>> naivePairs(const SetSection& set) {
+    std::vector<std::pair<int, int>> pairs;
+    set.reportIntersectionsNaive([&](int i, int j) {
+        pairs.push_back({ i, j });
+        return true;
+        });
+    return pairs;
+}
+
+std::vector<std::pair<int, int>> sweepPairs(const SetSection& set) {
+    std::vector<std::pair<int, int>> pairs = set.allIntersections();
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+}
+
+TEST(SetSection, collinear_disjoint_sections_do_not_intersect) {
+    SetSection set;
+    section a{ { 0, 0 }, { 1, 0 } };
+    section b{ { 2, 0 }, { 3, 0 } };
+    section c{ { 5, 0 }, { 5, 1 } };
+
+    EXPECT_FALSE(set.intersection(a, b));
+    EXPECT_FALSE(set.intersection(a, c));
+    EXPECT_TRUE(set.intersection(a, section{ { 1, 0 }, { 1, 1 } }));
+}
+
+TEST(SetSection, bentley_ottmann_reports_single_crossing) {
+    SetSection set;
+    set.add_section({ 0, 0 }, { 1, 1 });
+    set.add_section({ 0, 1 }, { 1, 0 });
+    set.add_section({ 2, 0 }, { 3, 1 });
+
+    std::vector<std::pair<int, int>> expected{ { 0, 1 } };
+    EXPECT_EQ(expected, sweepPairs(set));
+}
+
+TEST(SetSection, bentley_ottmann_handles_concurrent_and_axis_parallel_sections) {
+    SetSection set;
+    set.add_section({ 0, 0 }, { 1, 1 });
+    set.add_section({ 0, 1 }, { 1, 0 });
+    set.add_section({ 0.5, 0 }, { 0.5, 1 });
+    set.add_section({ 0, 0.5 }, { 1, 0.5 });
+    set.add_section({ 0.5, 0.75 }, { 0.5, 2 });    // наложение на вертикальный
+    set.add_section({ 1, 0.5 }, { 2, 0.5 });       // касание концом
+
+    EXPECT_EQ(naivePairs(set), sweepPairs(set));
+}
+
+TEST(SetSection, bentley_ottmann_handles_polyline_with_shared_endpoints) {
+    SetSection set;
+    set.add_section({ 0, 0 }, { 1, 0 });
+    set.add_section({ 1, 0 }, { 1, 1 });
+    set.add_section({ 1, 1 }, { 0, 1 });
+    set.add_section({ 0, 1 }, { 0, 0 });
+    set.add_section({ 2, 0 }, { 3, 0 });
+    set.add_section({ 2.5, 0 }, { 4, 0 });
+
+    std::vector<std::pair<int, int>> expected{ { 0, 1 }, { 0, 3 }, { 1, 2 }, { 2, 3 }, { 4, 5 } };
+    EXPECT_EQ(expected, sweepPairs(set));
+}
+
+TEST(SetSection, bentley_ottmann_matches_naive_on_random_sections) {
+    srand(1);
+    SetSection set;
+    set.generate_random_sections(300);
+
+    std::vector<std::pair<int, int>> expected = naivePairs(set);
+    ASSERT_FALSE(expected.empty());
+    EXPECT_EQ(expected, sweepPairs(set));
+}
+
+TEST(SetSection, bentley_ottmann_matches_naive_on_fixed_length_sections) {
+    srand(2);
+    SetSection set;
+    set.generate_sections_fixed_length(3000, 0.02);
+
+    EXPECT_EQ(naivePairs(set), sweepPairs(set));
+}
+
+TEST(SetSection, bentley_ottmann_stops_when_sink_returns_false) {
+    srand(3);
+    SetSection set;
+    set.generate_random_sections(100);
+
+    int calls = 0;
+    set.reportIntersections([&](int, int) {
+        ++calls;
+        return false;
+        });
+    EXPECT_EQ(1, calls);
+}
+
+TEST(SweepStatus, order_follows_sweep_position) {
+    std::vector<LineCoeffs> lines{
+        LineCoeffs::fromEnds(0, 0, 4, 4),
+        LineCoeffs::fromEnds(0, 3, 4, 1),
+    };
+    SweepStatus status(lines);
+    int other;
+
+    status.moveTo(0, 0);
+    status.insert(0);
+    status.moveTo(0, 3);
+    status.insert(1);
+    EXPECT_TRUE(status.below(1, other));
+    EXPECT_EQ(0, other);
+
+    // Правее точки пересечения (2, 2) порядок меняется без перевставки
+    status.moveTo(3, 0);
+    EXPECT_TRUE(status.above(1, other));
+    EXPECT_EQ(0, other);
+
+    status.erase(0);
+    EXPECT_EQ(1, status.size());
+}
+
+TEST(SetSection, effective_finds_touch_at_shared_endpoint) {
+    SetSection set;
+    set.add_section({ 0, 4 }, { 0, 6 });
+    set.add_section({ 0, 6 }, { 1, 4 });
+    set.add_section({ 3, 0 }, { 4, 1 });
+
+    section s1, s2;
+    EXPECT_TRUE(set.intersectionEffective(s1, s2));
+}
+
+TEST(SetSection, effective_matches_naive_on_fixed_length_sections) {
+    srand(4);
+    for (int n = 2; n < 400; n += 7) {
+        SetSection set;
+        set.generate_sections_fixed_length(n, 0.03);
+
+        section a, b, c, d;
+        bool naive = set.intersectionNaive(a, b);
+        ASSERT_EQ(naive, set.intersectionEffective(c, d)) << "n = " << n;
+        if (naive) {
+            EXPECT_TRUE(set.intersection(c, d));
+        }
+    }
+}
+
+TEST(SetSection, red_blue_reports_only_cross_layer_pairs) {
+    srand(5);
+    SetSection red, blue;
+    red.generate_sections_fixed_length(300, 0.1);
+    blue.generate_sections_fixed_length(2000, 0.05, 0.3, 1.5);
+
+    std::vector<std::pair<int, int>> expected, actual;
+    for (int i = 0; i < red.size(); ++i) {
+        for (int j = 0; j < blue.size(); ++j) {
+            if (red.intersection(red.getSection(i), blue.getSection(j))) {
+                expected.push_back({ i, j });
+            }
+        }
+    }
+    red.reportRedBlueIntersections(blue, [&](int i, int j) {
+        actual.push_back({ i, j });
+        return true;
+        });
+    std::sort(actual.begin(), actual.end());
+
+    ASSERT_FALSE(expected.empty());
+    EXPECT_EQ(expected, actual);
+}
+
+TEST(SetSection, red_blue_ignores_same_layer_crossings) {
+    SetSection red, blue;
+    red.add_section({ 0, 0 }, { 1, 1 });
+    red.add_section({ 0, 1 }, { 1, 0 });
+    blue.add_section({ 2, 0 }, { 3, 1 });
+    blue.add_section({ 2, 1 }, { 3, 0 });
+
+    section s1, s2;
+    EXPECT_FALSE(red.intersectionRedBlue(blue, s1, s2));
+
+    blue.add_section({ 0.5, -1 }, { 0.5, 0.7 });
+    ASSERT_TRUE(red.intersectionRedBlue(blue, s1, s2));
+    EXPECT_EQ(blue.getSection(2), s2);
+}
+
+TEST(SetSection, count_intersections_matches_naive) {
+    for (int seed = 0; seed < 20; ++seed) {
+        srand(seed);
+        SetSection set;
+        if (seed % 2) {
+            set.generate_random_sections(300);
+        }
+        else {
+            set.generate_sections_fixed_length(2000, 0.05);
+        }
+        EXPECT_EQ(set.countIntersectionsNaive(), set.countIntersections());
+    }
+}
+
+TEST(SetSection, count_intersections_on_integer_grid) {
+    // Много касаний концами, наложений и пересечений в общей точке
+    srand(7);
+    SetSection set;
+    for (int i = 0; i < 400; ++i) {
+        point a{ double(rand() % 9), double(rand() % 9) };
+        point b{ double(rand() % 9), double(rand() % 9) };
+        if (!(a == b)) set.add_section(a, b);
+    }
+    EXPECT_EQ(set.countIntersectionsNaive(), set.countIntersections());
+}
+
+TEST(SetSection, contact_kind_classifies_touches) {
+    section a{ { 0, 0 }, { 2, 0 } };
+
+    EXPECT_EQ(CONTACT_PROPER, SetSection::contactKind(a, section{ { 1, -1 }, { 1, 1 } }));
+    EXPECT_EQ(TOUCH_SHARED_ENDPOINT, SetSection::contactKind(a, section{ { 2, 0 }, { 3, 1 } }));
+    EXPECT_EQ(TOUCH_SHARED_ENDPOINT, SetSection::contactKind(a, section{ { 2, 0 }, { 3, 0 } }));
+    EXPECT_EQ(TOUCH_ENDPOINT_ON_INTERIOR, SetSection::contactKind(a, section{ { 1, 0 }, { 1, 1 } }));
+    EXPECT_EQ(TOUCH_COLLINEAR_OVERLAP, SetSection::contactKind(a, section{ { 1, 0 }, { 3, 0 } }));
+    EXPECT_EQ(0, SetSection::contactKind(a, section{ { 3, 0 }, { 4, 0 } }));
+}
+
+TEST(SetSection, network_mode_ignores_junctions) {
+    // Решётка дорог: отрезки встречаются только концами в узлах
+    SetSection set;
+    for (int x = 0; x < 10; ++x) {
+        for (int y = 0; y < 10; ++y) {
+            set.add_section({ double(x), double(y) }, { double(x + 1), double(y) });
+            set.add_section({ double(x), double(y) }, { double(x), double(y + 1) });
+        }
+    }
+    section s1, s2;
+    EXPECT_TRUE(set.intersectionEffective(s1, s2));
+
+    set.setTouchPolicy(TOUCH_NONE);
+    EXPECT_FALSE(set.intersectionEffective(s1, s2));
+    EXPECT_TRUE(set.allIntersections().empty());
+
+    // Примыкание к середине дороги считается, только если его разрешить
+    set.add_section({ 2.5, 3 }, { 2.5, 3.5 });
+    EXPECT_FALSE(set.intersectionEffective(s1, s2));
+    set.setTouchPolicy(TOUCH_ENDPOINT_ON_INTERIOR);
+    EXPECT_TRUE(set.intersectionEffective(s1, s2));
+}
+
+TEST(SetSection, touch_policies_match_naive) {
+    for (int seed = 0; seed < 800; ++seed) {
+        srand(seed);
+        SetSection set;
+        set.setTouchPolicy(seed % 8);
+        for (int i = 0; i < 30; ++i) {
+            point a{ double(rand() % 6), double(rand() % 6) };
+            point b{ double(rand() % 6), double(rand() % 6) };
+            if (!(a == b)) set.add_section(a, b);
+        }
+
+        section s1, s2;
+        EXPECT_EQ(set.intersectionNaive(s1, s2), set.intersectionEffective(s1, s2)) << "seed " << seed;
+        EXPECT_EQ(naivePairs(set), sweepPairs(set)) << "seed " << seed;
+    }
+}
+
+TEST(SetSection, orthogonal_engine_matches_naive) {
+    for (int seed = 0; seed < 400; ++seed) {
+        srand(seed);
+        SetSection set;
+        set.setTouchPolicy(seed % 8);
+        for (int i = 0; i < 40; ++i) {
+            // Целочисленная сетка: много касаний, углов и наложений
+            double x = rand() % 8, y = rand() % 8;
+            int length = 1 + rand() % 3;
+            if (rand() % 2) set.add_section({ x, y }, { x + length, y });
+            else set.add_section({ x, y }, { x, y + length });
+        }
+        ASSERT_TRUE(set.isOrthogonal());
+
+        section s1, s2;
+        EXPECT_EQ(set.intersectionNaive(s1, s2), set.intersectionEffective(s1, s2)) << "seed " << seed;
+        EXPECT_EQ(naivePairs(set), sweepPairs(set)) << "seed " << seed;
+    }
+}
+
+TEST(SetSection, orthogonal_engine_rejects_slanted_sections) {
+    SetSection set;
+    set.add_section({ 0, 0 }, { 1, 0 });
+    EXPECT_TRUE(set.isOrthogonal());
+
+    set.add_section({ 0, 0 }, { 1, 1 });
+    EXPECT_FALSE(set.isOrthogonal());
+    EXPECT_ANY_THROW(set.reportOrthogonalIntersections([](int, int) { return true; }));
+}
+
+TEST(SetSection, grid_engine_matches_naive) {
+    for (int seed = 0; seed < 300; ++seed) {
+        srand(seed);
+        SetSection set;
+        if (seed % 3 == 0) {
+            set.generate_sections_fixed_length(300, 0.05);
+        }
+        else if (seed % 3 == 1) {
+            set.generate_random_sections(60);
+        }
+        else {
+            for (int i = 0; i < 60; ++i) {
+                point a{ double(rand() % 9), double(rand() % 9) };
+                point b{ double(rand() % 9), double(rand() % 9) };
+                if (!(a == b)) set.add_section(a, b);
+            }
+        }
+
+        std::vector<std::pair<int, int>> pairs;
+        set.reportGridIntersections([&](int i, int j) {
+            pairs.push_back({ i, j });
+            return true;
+            });
+        std::sort(pairs.begin(), pairs.end());
+        EXPECT_EQ(naivePairs(set), pairs) << "seed " << seed;
+
+        section s1, s2;
+        EXPECT_EQ(set.intersectionNaive(s1, s2), set.intersectionGrid(s1, s2)) << "seed " << seed;
+    }
+}
+
+TEST(SetSection, prune_engine_matches_naive) {
+    for (int seed = 0; seed < 300; ++seed) {
+        srand(seed);
+        SetSection set;
+        if (seed % 3 == 0) {
+            set.generate_sections_fixed_length(300, 0.05);
+        }
+        else if (seed % 3 == 1) {
+            set.generate_random_sections(60);
+        }
+        else {
+            // Целочисленные концы: общие x левых краёв, вертикали и наложения
+            for (int i = 0; i < 60; ++i) {
+                point a{ double(rand() % 9), double(rand() % 9) };
+                point b{ double(rand() % 9), double(rand() % 9) };
+                if (!(a == b)) set.add_section(a, b);
+            }
+        }
+        set.setTouchPolicy(seed % 8);
+
+        std::vector<std::pair<int, int>> pairs;
+        set.reportPruneIntersections([&](int i, int j) {
+            pairs.push_back({ i, j });
+            return true;
+            });
+        std::sort(pairs.begin(), pairs.end());
+        EXPECT_EQ(naivePairs(set), pairs) << "seed " << seed;
+
+        section s1, s2;
+        EXPECT_EQ(set.intersectionNaive(s1, s2), set.findIntersection(s1, s2, ENGINE_PRUNE)) << "seed " << seed;
+    }
+}
+
+TEST(SetSection, choose_engine_follows_cost_model) {
+    SetSection tiny;
+    tiny.generate_sections_fixed_length(5, 0.1);
+    EXPECT_EQ(ENGINE_NAIVE, tiny.chooseEngine());
+
+    SetSection short_sections;
+    short_sections.generate_sections_fixed_length(20000, 0.001);
+    EXPECT_EQ(ENGINE_GRID, short_sections.chooseEngine());
+
+    SetSection long_sections;
+    long_sections.generate_random_sections(20000);
+    EXPECT_EQ(ENGINE_SWEEP, long_sections.chooseEngine());
+
+    // Модель, в которой перебор бесплатен, всегда выбирает перебор
+    CostModel model;
+    model.naive_pair = 0;
+    long_sections.setCostModel(model);
+    EXPECT_EQ(ENGINE_NAIVE, long_sections.chooseEngine());
+}
+
+TEST(SetSection, find_intersection_matches_naive) {
+    for (int seed = 0; seed < 200; ++seed) {
+        srand(seed);
+        SetSection set;
+        int n = 2 + rand() % 400;
+        switch (seed % 4) {
+        case 0: set.generate_sections_fixed_length(n, 0.01); break;
+        case 1: set.generate_random_sections(n); break;
+        case 2: set.generate_orthogonal_sections(n, 0.02); break;
+        default: set.generate_controlled_sections(n / 4 + 2, 0); break;
+        }
+
+        section s1, s2, n1, n2;
+        bool found = set.findIntersection(s1, s2);
+        EXPECT_EQ(set.intersectionNaive(n1, n2), found) << "seed " << seed;
+        if (found) EXPECT_TRUE(set.intersection(s1, s2));
+    }
+}
+
+TEST(SetSection, calibrated_cost_model_is_positive) {
+    CostModel model = SetSection::calibrateCostModel(2000);
+
+    EXPECT_GT(model.naive_pair, 0);
+    EXPECT_GT(model.sweep_event, 0);
+    EXPECT_GT(model.orthogonal_event, 0);
+    EXPECT_GE(model.grid_item, 0);
+    EXPECT_GE(model.prune_item, 0);
+}
+
+TEST(SetSectionInt, calibrated_cost_model_is_positive) {
+    // Калибровочные наборы строятся в целых координатах, а не округляются до точки (0, 0)
+    CostModel model = SetSectionInt::calibrateCostModel(2000);
+
+    EXPECT_GT(model.naive_pair, 0);
+    EXPECT_GT(model.sweep_event, 0);
+    EXPECT_GT(model.orthogonal_event, 0);
+    EXPECT_GE(model.grid_item, 0);
+    EXPECT_GE(model.prune_item, 0);
+}
+
+TEST(SetSection, parallel_detection_matches_naive) {
+    for (int seed = 0; seed < 300; ++seed) {
+        srand(seed);
+        SetSection set;
+        int n = 2 + rand() % 300;
+        if (seed % 3 == 0) {
+            set.generate_sections_fixed_length(n, 0.01);
+        }
+        else if (seed % 3 == 1) {
+            set.generate_controlled_sections(n / 4 + 2, 0);
+        }
+        else {
+            for (int i = 0; i < n / 4 + 2; ++i) {
+                point a{ double(rand() % 12), double(rand() % 12) };
+                point b{ double(rand() % 12), double(rand() % 12) };
+                if (!(a == b)) set.add_section(a, b);
+            }
+            set.setTouchPolicy(TOUCH_NONE);
+        }
+
+        section s1, s2, n1, n2;
+        bool found = set.intersectionParallel(s1, s2, 1 + seed % 6);
+        EXPECT_EQ(set.intersectionNaive(n1, n2), found) << "seed " << seed;
+        if (found) EXPECT_TRUE(set.intersection(s1, s2, set.touchPolicy()));
+    }
+}
+
+TEST(SetSection, section_view_follows_mutations) {
+    SetSection set;
+    set.add_section({ 0, 0 }, { 1, 2 });
+    set.add_section({ 3, 4 }, { 5, 6 });
+
+    SectionView v = set.view();
+    ASSERT_EQ(v.n, 2);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(v.x0) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(v.y1) % 64, 0u);
+    EXPECT_EQ(v.x1[1], 5);
+
+    set.setSection(1, section{ { 3, 4 }, { 7, 6 } });
+    set.add_section({ 8, 9 }, { 10, 11 });
+    v = set.view();
+    ASSERT_EQ(v.n, 3);
+    EXPECT_EQ(v.x1[1], 7);
+    EXPECT_EQ(v[2].begin.x, 8);
+    EXPECT_EQ(v[2].end.y, 11);
+}
+
+// Маска ядра для типа координат T не теряет ни одной пары, которую SetSectionT<T>::intersection считает пересекающейся
+template <typename T>
+void checkKernelNeverDrops(unsigned seed) {
+    std::vector<BatchIsa> isas = { BATCH_SCALAR };
+    if (BatchKernel::detect() >= BATCH_AVX2) isas.push_back(BATCH_AVX2);
+    if (BatchKernel::detect() >= BATCH_AVX512) isas.push_back(BATCH_AVX512);
+
+    srand(seed);
+    for (int round = 0; round < 3000; ++round) {
+        // Целочисленная сетка даёт много касаний и коллинеарных наложений, дробные координаты - обычные случаи
+        double scale = round % 2 ? 6.0 : 1e6;
+        auto coord = [&]() { return T(round % 2 ? double(rand() % 7) : scale * rand() / RAND_MAX); };
+        pointT<T> a{ coord(), coord() }, b{ coord(), coord() };
+        int count = 1 + rand() % BatchKernel::BLOCK;
+        std::vector<T> x0(count), y0(count), x1(count), y1(count);
+        std::vector<T> xmin(count), ymin(count), xmax(count), ymax(count);
+        for (int k = 0; k < count; ++k) {
+            x0[k] = coord(); y0[k] = coord(); x1[k] = coord(); y1[k] = coord();
+            xmin[k] = std::min(x0[k], x1[k]); xmax[k] = std::max(x0[k], x1[k]);
+            ymin[k] = std::min(y0[k], y1[k]); ymax[k] = std::max(y0[k], y1[k]);
+        }
+        BatchBlockT<T> block{ x0.data(), y0.data(), x1.data(), y1.data(), xmin.data(), ymin.data(), xmax.data(), ymax.data(), count };
+
+        for (BatchIsa isa : isas) {
+            uint32_t mask = BatchKernel::function<T>(isa)(a.x, a.y, b.x, b.y, block);
+            if (count < 32) EXPECT_EQ(mask >> count, 0u);
+            for (int k = 0; k < count; ++k) {
+                sectionT<T> other{ { x0[k], y0[k] }, { x1[k], y1[k] } };
+                if (SetSectionT<T>::intersection({ a, b }, other)) {
+                    EXPECT_TRUE(mask >> k & 1) << "isa " << isa << ", round " << round << ", lane " << k;
+                }
+            }
+        }
+    }
+}
+
+TEST(BatchKernel, never_drops_intersecting_segments) {
+    checkKernelNeverDrops<double>(7);
+}
+
+TEST(BatchKernel, never_drops_intersecting_float_segments) {
+    checkKernelNeverDrops<float>(8);
+}
+
+TEST(BatchKernel, scan_matches_block_masks) {
+    srand(11);
+    SetSection set;
+    set.generate_sections_fixed_length(300, 0.05);
+    SectionView v = set.view();
+    section a = v[0];
+    BatchBlock row = v.block(1, v.n - 1);
+
+    for (BatchIsa isa : { BATCH_SCALAR, BATCH_AVX2, BATCH_AVX512 }) {
+        if (isa > BatchKernel::detect()) continue;
+        std::vector<int> scanned, blocked;
+        uint32_t mask;
+        for (int k = 0; (k = BatchKernel::scanFunction<double>(isa)(a.begin.x, a.begin.y, a.end.x, a.end.y, row, k, mask)) < row.count;
+            k += BatchKernel::BLOCK) {
+            for (int j = 0; j < BatchKernel::BLOCK; ++j) {
+                if (mask >> j & 1) scanned.push_back(k + j);
+            }
+        }
+        for (int k = 0; k < row.count; ++k) {
+            BatchBlock one = row.offset(k);
+            one.count = 1;
+            if (BatchKernel::function<double>(isa)(a.begin.x, a.begin.y, a.end.x, a.end.y, one)) blocked.push_back(k);
+        }
+        EXPECT_EQ(scanned, blocked) << "isa " << isa;
+    }
+}
+
+TEST(SetSection, parallel_naive_returns_first_pair) {
+    for (int seed = 0; seed < 12; ++seed) {
+        srand(seed);
+        SetSection set;
+        int n = 2048 + rand() % 3000;
+        set.generate_sections_fixed_length(n, seed % 3 == 0 ? 0.0005 : 0.004);
+        if (seed % 4 == 1) set.setTouchPolicy(TOUCH_NONE);
+
+        section n1, n2;
+        bool expected = set.intersectionNaive(n1, n2);
+        for (int threads : { 2, 3, 5 }) {
+            section s1, s2;
+            ASSERT_EQ(set.intersectionNaiveParallel(s1, s2, threads), expected) << "seed " << seed;
+            if (expected) {
+                EXPECT_TRUE(s1 == n1 && s2 == n2) << "seed " << seed << ", threads " << threads;
+            }
+        }
+    }
+}
+
+TEST(SetSectionFloat, engines_match_naive) {
+    for (int seed = 0; seed < 300; ++seed) {
+        srand(seed);
+        SetSectionFloat set;
+        int n = 2 + rand() % 200;
+        if (seed % 3 == 0) {
+            set.generate_sections_fixed_length(n, 0.05);
+        }
+        else if (seed % 3 == 1) {
+            set.generate_controlled_sections(n / 4 + 2, 0);
+        }
+        else {
+            for (int i = 0; i < n / 3 + 2; ++i) {
+                SetSectionFloat::point a{ float(rand() % 9), float(rand() % 9) };
+                SetSectionFloat::point b{ float(rand() % 9), float(rand() % 9) };
+                if (!(a == b)) set.add_section(a, b);
+            }
+            set.setTouchPolicy(seed % 8);
+        }
+
+        SetSectionFloat::section s1, s2;
+        bool expected = set.intersectionNaive(s1, s2);
+        EXPECT_EQ(set.intersectionEffective(s1, s2), expected) << "seed " << seed;
+        EXPECT_EQ(set.intersectionGrid(s1, s2), expected) << "seed " << seed;
+        long long count = set.countIntersectionsNaive();
+        EXPECT_EQ(set.countIntersections(), count) << "seed " << seed;
+        EXPECT_EQ((long long)set.allIntersections().size(), count) << "seed " << seed;
+    }
+}
+
+TEST(SetSectionFloat, float_lanes_are_half_size) {
+    SetSectionFloat set;
+    set.add_section({ 0.5f, 0.25f }, { 1.5f, 2.0f });
+    SetSectionFloat::SectionView v = set.view();
+    EXPECT_EQ(sizeof(*v.x0), sizeof(float));
+    EXPECT_EQ(sizeof(SetSectionFloat::section), 16u);
+    EXPECT_EQ(v.y1[0], 2.0f);
+}
+
+TEST(SetSectionInt, exact_side_separates_near_collinear_points) {
+    // Точка C ниже прямой AB на 2 единицы векторного произведения: в double оба произведения
+    // порядка 4.6e18 округляются до кратных 512, и разность пропадает
+    const int32_t p = 2147483647, q = 2147483645;
+    SetSectionInt::point A{ 0, 0 }, B{ p, q }, C{ p - 1, q - 1 };
+    EXPECT_EQ(SetSectionInt::side(A, B, C), 2);
+    EXPECT_EQ(SetSectionInt::side(A, C, B), 1);
+    EXPECT_EQ(SetSectionInt::side(A, B, { -p, -q }), 0);
+
+    SetSectionInt set;
+    set.add_section(A, B);
+    set.add_section(C, { p - 1, q - 1001 });
+    SetSectionInt::section s1, s2;
+    EXPECT_FALSE(set.intersectionNaive(s1, s2));
+    EXPECT_FALSE(set.intersectionEffective(s1, s2));
+
+    set.add_section({ p - 3, q - 5 }, { p - 3, q + 1 });
+    EXPECT_TRUE(set.intersectionNaive(s1, s2));
+    EXPECT_TRUE(set.intersectionEffective(s1, s2));
+}
+
+TEST(SetSectionInt, engines_match_naive) {
+    for (int seed = 0; seed < 300; ++seed) {
+        std::mt19937 gen(seed);
+        SetSectionInt set;
+        int n = 2 + gen() % 150;
+        for (int i = 0; i < n; ++i) {
+            SetSectionInt::point a, b;
+            if (seed % 2 == 0) {
+                // Мелкая сетка: много касаний, наложений и общих концов
+                a = { int32_t(gen() % 9), int32_t(gen() % 9) };
+                b = { int32_t(gen() % 9), int32_t(gen() % 9) };
+            }
+            else {
+                // Почти коллинеарные отрезки с координатами у границы int32
+                int64_t t1 = gen() % 1000000, t2 = gen() % 1000000;
+                a = { int32_t(t1 * 2000 - 1000000000), int32_t(t1 * 1999 - 1000000000 + int(gen() % 5) - 2) };
+                b = { int32_t(t2 * 2000 - 1000000000), int32_t(t2 * 1999 - 1000000000 + int(gen() % 5) - 2) };
+            }
+            if (!(a == b)) set.add_section(a, b);
+        }
+        set.setTouchPolicy(seed % 8);
+
+        SetSectionInt::section s1, s2;
+        bool expected = set.intersectionNaive(s1, s2);
+        EXPECT_EQ(set.intersectionEffective(s1, s2), expected) << "seed " << seed;
+        EXPECT_EQ(set.intersectionParallel(s1, s2, 3), expected) << "seed " << seed;
+        EXPECT_EQ(set.intersectionGrid(s1, s2), expected) << "seed " << seed;
+    }
+}
+
+TEST(SetSectionInt, parallel_clips_long_segments_to_lattice_points) {
+    // Параллельные длинные отрезки с шагом целых точек (100, 1) проходят много полос и обрезаются
+    // в целых точках; пересечение есть, только если его даёт одна из коротких вертикалей
+    for (int seed = 0; seed < 200; ++seed) {
+        std::mt19937 gen(seed);
+        SetSectionInt set;
+        for (int i = 0; i < 60; ++i) {
+            int32_t x = int32_t(gen() % 1000) * 10;
+            int32_t m = int32_t(1 + gen() % 5);
+            set.add_section({ x, 40 * i }, { x + 1000 * m, 40 * i + 10 * m });
+        }
+        for (int i = 0; i < 3; ++i) {
+            int32_t x = int32_t(gen() % 15000);
+            int32_t y = int32_t(gen() % 2400);
+            set.add_section({ x, y }, { x, y + 12 });
+        }
+        set.setTouchPolicy(seed % 8);
+
+        SetSectionInt::section s1, s2;
+        bool expected = set.intersectionNaive(s1, s2);
+        EXPECT_EQ(set.intersectionParallel(s1, s2, 2 + seed % 7), expected) << "seed " << seed;
+    }
+}
+
+TEST(SetSectionInt, generated_sets_have_no_point_sections) {
+    // По умолчанию целые координаты берутся в квадрате generatorRange(), а не в единичном
+    for (int kind = 0; kind < 5; ++kind) {
+        srand(kind);
+        SetSectionInt set;
+        int n = 500;
+        switch (kind) {
+        case 0: set.generate_random_sections(n); break;
+        case 1: set.generate_sections_fixed_length(n, 3.0); break;
+        case 2: set.generate_orthogonal_sections(n, 1.0); break;
+        case 3: set.generate_controlled_sections(n, n / 4); break;
+        default: set.generate_controlled_fixed_length_sections(n, n / 4, 2000.0); break;
+        }
+        if (kind < 3) {
+            EXPECT_EQ(set.size(), size_t(n)) << "kind " << kind;
+        }
+        ASSERT_GT(set.size(), 0u) << "kind " << kind;
+        for (int i = 0; i < int(set.size()); ++i) {
+            const SetSectionInt::section& sec = set.getSection(i);
+            EXPECT_FALSE(sec.begin == sec.end) << "kind " << kind << " section " << i;
+        }
+    }
+
+    // Отрезки короче 1 округлились бы в точки
+    SetSectionInt set;
+    EXPECT_THROW(set.generate_sections_fixed_length(10, 0.02), std::runtime_error);
+    EXPECT_THROW(set.generate_orthogonal_sections(10, 0.5), std::runtime_error);
+    EXPECT_THROW(set.generate_random_sections(10, 0.0, 0.5), std::runtime_error);
+}
+
+TEST(WideInt, matches_builtin_arithmetic) {
+    std::mt19937_64 gen(7);
+    for (int round = 0; round < 10000; ++round) {
+        int64_t a = int64_t(gen()) >> (gen() % 64), b = int64_t(gen()) >> (gen() % 64);
+        int64_t c = int64_t(gen()) >> (gen() % 64), d = int64_t(gen()) >> (gen() % 64);
+        Int128 wide = Int128(a) * b - Int128(c) * d;
+        Int128 zero = Int128(a) * b - Int128(a) * b;
+        EXPECT_TRUE(zero == Int128(0));
+        EXPECT_EQ(wideSign(Int128(a) * b + Int128(c) * d - Int128(c) * d - Int128(a) * b), 0);
+#if defined(__SIZEOF_INT128__)
+        __int128 exact = __int128(a) * b - __int128(c) * d;
+        EXPECT_EQ(wideSign(wide), wideSign(exact)) << a << " " << b << " " << c << " " << d;
+        EXPECT_EQ(Int128(a) * b < Int128(c) * d, __int128(a) * b < __int128(c) * d);
+#else
+        (void)wide;
+#endif
+    }
+}
+
+TEST(RobustPredicates, orient_is_exact_near_collinear_points) {
+    // Прямая y = x через (12, 12) и (24, 24); точки сетки у (0.5, 0.5) с шагом в единицу
+    // последнего разряда - обычный det здесь даёт случайный знак
+    double ulp = std::ldexp(1.0, -53);
+    for (int i = 0; i < 64; ++i) {
+        for (int j = 0; j < 64; ++j) {
+            double cx = 0.5 + i * ulp, cy = 0.5 + j * ulp;
+            int expected = cy > cx ? 1 : cy < cx ? 2 : 0;
+            EXPECT_EQ(SetSection::side({ 12, 12 }, { 24, 24 }, { cx, cy }), expected) << i << " " << j;
+            EXPECT_EQ(SetSection::side({ 24, 24 }, { 12, 12 }, { cx, cy }), expected == 0 ? 0 : 3 - expected);
+        }
+    }
+}
+
+TEST(RobustPredicates, filter_agrees_with_exact_sum) {
+    std::mt19937_64 gen(17);
+    std::uniform_real_distribution<double> coord(-1e6, 1e6);
+    for (int round = 0; round < 20000; ++round) {
+        double ax = coord(gen), ay = coord(gen), bx = coord(gen), by = coord(gen);
+        // C на прямой AB с точностью до округления: знак решает точная сумма
+        double t = coord(gen) / 1e6;
+        double cx = ax + t * (bx - ax), cy = ay + t * (by - ay);
+        EXPECT_EQ(RobustPredicates::orient(ax, ay, bx, by, cx, cy), RobustPredicates::crossExact(ax, ay, bx, by, ax, ay, cx, cy));
+
+        // Целые координаты до 2^40: точный знак известен из 128-битного произведения
+        int64_t q[8];
+        for (int64_t& v : q) v = int64_t(gen() % (int64_t(1) << 41)) - (int64_t(1) << 40);
+        wide_int det = wide_int(q[2] - q[0]) * (q[7] - q[5]) - wide_int(q[3] - q[1]) * (q[6] - q[4]);
+        EXPECT_EQ(RobustPredicates::crossExact(double(q[0]), double(q[1]), double(q[2]), double(q[3]),
+            double(q[4]), double(q[5]), double(q[6]), double(q[7])), wideSign(det));
+    }
+}
+
+TEST(SetSection, intersection_points_lie_on_both_sections) {
+    srand(11);
+    SetSection set;
+    set.generate_sections_fixed_length(3000, 0.05);
+    std::vector<std::pair<int, int>> pairs = set.allIntersections();
+    ASSERT_GT(pairs.size(), 1000u);
+
+    std::vector<Crossing> points = set.intersectionPoints(pairs);
+    std::vector<Crossing> parallel = set.intersectionPoints(pairs, 3);
+    ASSERT_EQ(points.size(), pairs.size());
+    for (size_t k = 0; k < pairs.size(); ++k) {
+        const Crossing& c = points[k];
+        EXPECT_TRUE(c.begin == parallel[k].begin && c.end == parallel[k].end);
+        for (int id : { pairs[k].first, pairs[k].second }) {
+            const SetSection::section& sec = set.getSection(id);
+            // Расстояние от точки до прямой отрезка и попадание в его прямоугольник
+            double len = std::hypot(sec.end.x - sec.begin.x, sec.end.y - sec.begin.y);
+            double dist = std::abs((sec.end.x - sec.begin.x) * (c.begin.y - sec.begin.y) -
+                (sec.end.y - sec.begin.y) * (c.begin.x - sec.begin.x)) / len;
+            EXPECT_LT(dist, 1e-12);
+            EXPECT_LE(std::min(sec.begin.x, sec.end.x) - 1e-12, c.begin.x);
+            EXPECT_GE(std::max(sec.begin.x, sec.end.x) + 1e-12, c.begin.x);
+        }
+    }
+}
+
+TEST(SetSection, intersection_points_of_touches_and_overlaps) {
+    SetSection set;
+    set.add_section({ 0, 0 }, { 4, 4 });
+    set.add_section({ 6, 6 }, { 2, 2 });    // наложение [2, 4] на той же прямой
+    set.add_section({ 4, 4 }, { 8, 0 });    // общий конец (4, 4)
+    set.add_section({ 0, 4 }, { 4, 0 });    // собственное пересечение в (2, 2)
+    set.add_section({ 1, 1 }, { 1, -3 });   // конец на внутренней точке первого
+
+    std::vector<std::pair<int, int>> pairs{ { 0, 1 }, { 0, 2 }, { 0, 3 }, { 0, 4 }, { 1, 3 } };
+    std::vector<Crossing> c = set.intersectionPoints(pairs);
+    EXPECT_TRUE(c[0].begin == point({ 2, 2 }) && c[0].end == point({ 4, 4 }));
+    EXPECT_TRUE(c[1].begin == point({ 4, 4 }) && c[1].end == point({ 4, 4 }));
+    EXPECT_TRUE(c[2].begin == point({ 2, 2 }) && c[2].end == point({ 2, 2 }));
+    EXPECT_TRUE(c[3].begin == point({ 1, 1 }) && c[3].end == point({ 1, 1 }));
+    EXPECT_TRUE(c[4].begin == point({ 2, 2 }) && c[4].end == point({ 2, 2 }));
+}
+
+TEST(RadixSort, matches_stable_sort_for_any_thread_count) {
+    std::mt19937_64 gen(3);
+    std::vector<uint64_t> keys(100000);
+    for (uint64_t& key : keys) key = gen() >> (gen() % 64);
+    std::vector<int> ids(keys.size());
+    for (size_t i = 0; i < ids.size(); ++i) ids[i] = int(i);
+
+    std::vector<int> expected = ids;
+    std::stable_sort(expected.begin(), expected.end(), [&](int a, int b) { return keys[a] < keys[b]; });
+    for (int threads : { 1, 3 }) {
+        std::vector<uint64_t> k = keys;
+        std::vector<int> v = ids;
+        RadixSort::sortPairs(k, v, threads);
+        EXPECT_EQ(v, expected) << threads;
+        EXPECT_TRUE(std::is_sorted(k.begin(), k.end()));
+    }
+}
+
+TEST(RadixSort, ordered_key_keeps_double_order) {
+    const double inf = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> values{ -inf, -1e300, -1, -1e-300, -0.0, 0.0, 1e-300, 1, 1e300, inf };
+    for (size_t i = 1; i < values.size(); ++i) {
+        if (values[i - 1] < values[i]) {
+            EXPECT_LT(RadixSort::orderedKey(values[i - 1]), RadixSort::orderedKey(values[i])) << i;
+        }
+        else {
+            EXPECT_EQ(RadixSort::orderedKey(values[i - 1]), RadixSort::orderedKey(values[i])) << i;
+        }
+    }
+    EXPECT_GT(RadixSort::orderedKey(nan), RadixSort::orderedKey(inf));
+    EXPECT_EQ(RadixSort::orderedKey(nan), RadixSort::orderedKey(-nan));
+}
+
+TEST(Event, radix_sort_matches_stable_sort) {
+    for (int seed = 0; seed < 20; ++seed) {
+        srand(seed);
+        SetSection set;
+        int n = seed < 10 ? 100 + seed * 20 : 40000;
+        if (seed % 2) {
+            set.generate_random_sections(n);
+        }
+        else {
+            // Общие концы, вертикали и нули разного знака
+            for (int i = 0; i < n; ++i) {
+                point a{ double(rand() % 9 - 4) * 0.0, double(rand() % 9) };
+                a.x = rand() % 3 ? double(rand() % 9) : a.x;
+                point b{ double(rand() % 9), double(rand() % 9) };
+                if (!(a == b)) set.add_section(a, b);
+            }
+        }
+
+        std::vector<Event> events;
+        for (int i = 0; i < set.size(); ++i) {
+            section s = set.getSection(i);
+            point left = s.begin, right = s.end;
+            if (right < left) std::swap(left, right);
+            events.push_back({ left, i, true });
+            events.push_back({ right, i, false });
+        }
+        std::vector<Event> expected = events;
+        std::stable_sort(expected.begin(), expected.end());
+        Event::sort(events);
+
+        ASSERT_EQ(expected.size(), events.size());
+        for (size_t k = 0; k < events.size(); ++k) {
+            ASSERT_TRUE(expected[k].p == events[k].p && expected[k].is_left == events[k].is_left &&
+                expected[k].segment_index == events[k].segment_index) << "seed " << seed << " event " << k;
+        }
+    }
+}
+
+TEST(CompactEvent, order_matches_event_sort) {
+    for (int seed = 0; seed < 10; ++seed) {
+        srand(seed);
+        SetSection set;
+        for (int i = 0; i < 2000; ++i) {
+            point a{ double(rand() % 20), double(rand() % 20) };
+            point b{ double(rand() % 20), double(rand() % 20) };
+            if (!(a == b)) set.add_section(a, b);
+        }
+
+        std::vector<Event> expected;
+        for (int i = 0; i < set.size(); ++i) {
+            section s = set.getSection(i);
+            point left = s.begin, right = s.end;
+            if (right < left) std::swap(left, right);
+            expected.push_back({ left, i, true });
+            expected.push_back({ right, i, false });
+        }
+        Event::sort(expected);
+
+        std::vector<CompactEvent> events;
+        set.prepareCompactEvents(events);
+        ASSERT_EQ(expected.size(), events.size());
+        SetSection::SectionView v = set.view();
+        for (size_t k = 0; k < events.size(); ++k) {
+            ASSERT_EQ(expected[k].segment_index, events[k].segment()) << "seed " << seed << " event " << k;
+            ASSERT_EQ(expected[k].is_left, events[k].isLeft());
+            ASSERT_TRUE(expected[k].p == SetSection::eventPoint(v, events[k]));
+        }
+    }
+}
+
+TEST(CompactEvent, parallel_sort_matches_serial) {
+    srand(23);
+    SetSection set;
+    for (int i = 0; i < 50000; ++i) {
+        point a{ double(rand() % 500), double(rand() % 500) };
+        point b{ double(rand() % 500), double(rand() % 500) };
+        if (!(a == b)) set.add_section(a, b);
+    }
+
+    std::vector<CompactEvent> serial, parallel;
+    set.prepareCompactEvents(serial);
+    set.setSortThreads(3);
+    set.prepareCompactEvents(parallel);
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (size_t k = 0; k < serial.size(); ++k) {
+        ASSERT_EQ(serial[k].code, parallel[k].code) << k;
+    }
+}
+
+TEST(SetSection, concurrent_const_queries_build_cache_once) {
+    srand(11);
+    SetSection set;
+    set.generate_sections_fixed_length(3000, 0.02);
+    section n1, n2;
+    bool expected = set.intersectionNaive(n1, n2);
+    set.add_section({ 2, 2 }, { 3, 3 });    // сброс кэша: его построят сами потоки
+
+    const SetSection& shared = set;
+    std::vector<int> results(4, -1);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&, t] {
+            section s1, s2;
+            results[t] = shared.intersectionEffective(s1, s2);
+            });
+    }
+    for (std::thread& w : workers) {
+        w.join();
+    }
+    for (int r : results) {
+        EXPECT_EQ(int(expected), r);
+    }
+}
+
+TEST(SetSection, cached_events_follow_mutations) {
+    SetSection set;
+    set.add_section({ 0, 0 }, { 1, 0 });
+    set.add_section({ 0, 1 }, { 1, 1 });
+    set.prepare();
+
+    section s1, s2;
+    EXPECT_FALSE(set.intersectionEffective(s1, s2));
+    EXPECT_FALSE(set.intersectionEffective(s1, s2));
+
+    // Замена через setSection: второй отрезок опускается на первый
+    set.setSection(1, section{ { 0.5, -1 }, { 0.5, 1 } });
+    EXPECT_TRUE(set.intersectionEffective(s1, s2));
+
+    set.setSection(1, section{ { 0, 1 }, { 1, 1 } });
+    EXPECT_FALSE(set.intersectionEffective(s1, s2));
+    set.add_section({ 2, 2 }, { 0.5, 0 });
+    EXPECT_TRUE(set.intersectionEffective(s1, s2));
+
+    srand(24);
+    set.generate_sections_fixed_length(500, 0.05);
+    section n1, n2;
+    EXPECT_EQ(set.intersectionNaive(n1, n2), set.intersectionEffective(s1, s2));
+
+    // Замена после запроса, как запись через сохранённую ссылку: следующий запрос видит новые данные
+    for (int k = 0; k < 20; ++k) {
+        set.countIntersections();
+        section sec = set.getSection(k);
+        set.setSection(k, section{ sec.begin, { sec.end.x + 0.1, sec.end.y + 0.1 } });
+        EXPECT_EQ(set.countIntersectionsNaive(), set.countIntersections()) << "k = " << k;
+    }
+    EXPECT_THROW(set.setSection(0, section{ { 1, 1 }, { 1, 1 } }), std::runtime_error);
+}
+
+TEST(SetSection, workspace_reused_across_sets) {
+    SweepWorkspace workspace;
+    int sizes[] = { 2000, 50, 800, 0, 3000 };
+    unsigned seed = 25;
+    for (int n : sizes) {
+        for (bool integer : { false, true }) {
+            srand(seed++);
+            SetSection set;
+            set.generate_sections_fixed_length(n, 0.02);
+            if (integer) {
+                for (int i = 0; i < n; ++i) {
+                    section sec = set.getSection(i);
+                    set.setSection(i, section{ { std::floor(sec.begin.x * 1000), std::floor(sec.begin.y * 1000) },
+                        { std::floor(sec.end.x * 1000), std::floor(sec.end.y * 1000) } });
+                }
+            }
+            section n1, n2, s1, s2;
+            bool expected = set.intersectionNaive(n1, n2);
+            EXPECT_EQ(set.intersectionEffective(s1, s2, workspace), expected);
+            EXPECT_EQ(set.intersectionPrune(s1, s2, workspace), expected);
+            EXPECT_EQ(set.findIntersection(s1, s2, workspace), expected);
+
+            std::vector<std::pair<int, int>> pruned;
+            set.reportPruneIntersections([&](int i, int j) {
+                pruned.push_back({ i, j });
+                return true;
+                }, workspace);
+            std::vector<std::pair<int, int>> naive = naivePairs(set);
+            std::sort(pruned.begin(), pruned.end());
+            std::sort(naive.begin(), naive.end());
+            EXPECT_EQ(pruned, naive);
+        }
+    }
+}
+
+TEST(SetSection, spatial_reorder_keeps_original_indices) {
+    for (SpaceCurve curve : { CURVE_MORTON, CURVE_HILBERT }) {
+        srand(21);
+        SetSection set;
+        set.generate_sections_fixed_length(3000, 0.03);
+        SetSection reordered = set;
+        reordered.reorderSpatially(curve, 2);
+
+        std::vector<std::pair<int, int>> expected = naivePairs(set);
+        std::vector<std::pair<int, int>> naive = naivePairs(reordered);
+        std::sort(expected.begin(), expected.end());
+        std::sort(naive.begin(), naive.end());
+        EXPECT_EQ(naive, expected);
+        EXPECT_EQ(sweepPairs(reordered), expected);
+
+        std::vector<std::pair<int, int>> grid;
+        reordered.reportGridIntersections([&](int i, int j) {
+            grid.push_back({ i, j });
+            return true;
+            });
+        std::sort(grid.begin(), grid.end());
+        EXPECT_EQ(grid, expected);
+
+        std::vector<Crossing> before = set.intersectionPoints(expected);
+        std::vector<Crossing> after = reordered.intersectionPoints(expected);
+        bool same_sections = true, same_points = true;
+        for (int i = 0; i < int(set.size()); ++i) {
+            same_sections = same_sections && set.getSection(i) == reordered.getSection(i);
+        }
+        for (size_t k = 0; k < expected.size(); ++k) {
+            same_points = same_points && before[k].begin == after[k].begin && before[k].end == after[k].end;
+        }
+        EXPECT_TRUE(same_sections);
+        EXPECT_TRUE(same_points);
+
+        // Соседние позиции - в среднем близкие отрезки
+        SetSection::SectionView v = reordered.view();
+        double step = 0.0;
+        for (int i = 1; i < v.n; ++i) {
+            step += std::abs(v.x0[i] - v.x0[i - 1]) + std::abs(v.y0[i] - v.y0[i - 1]);
+        }
+        EXPECT_LT(step / (v.n - 1), 0.1);
+
+        // Добавленный после перестановки отрезок получает следующий исходный индекс
+        reordered.add_section({ 2, 2 }, { 3, 3 });
+        EXPECT_EQ(reordered.getSection(3000).begin, point({ 2, 2 }));
+        EXPECT_EQ(reordered.originalIndex(3000), 3000);
+    }
+}
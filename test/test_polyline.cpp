@@ -0,0 +1,61 @@
+#include "polyline.h"
+#include <gtest.h>
+
+TEST(Polyline, square_ring_is_simple) {
+    Polyline ring({ { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } }, true);
+
+    EXPECT_EQ(4, ring.edgeCount());
+    EXPECT_TRUE(ring.isSimple());
+}
+
+TEST(Polyline, closing_vertex_repeat_is_allowed) {
+    std::vector<point> v{ { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 } };
+
+    EXPECT_TRUE(Polyline::isSimple(v.data(), v.size(), true));
+    EXPECT_FALSE(Polyline::isSimple(v.data(), v.size(), false));
+}
+
+TEST(Polyline, bow_tie_is_not_simple) {
+    Polyline ring({ { 0, 0 }, { 1, 1 }, { 1, 0 }, { 0, 1 } }, true);
+
+    int e1, e2;
+    ASSERT_TRUE(ring.findSelfIntersection(e1, e2));
+    EXPECT_EQ(0, e1);
+    EXPECT_EQ(2, e2);
+}
+
+TEST(Polyline, backtracking_adjacent_edges_are_not_simple) {
+    Polyline line({ { 0, 0 }, { 2, 0 }, { 1, 0 } });
+
+    int e1, e2;
+    ASSERT_TRUE(line.findSelfIntersection(e1, e2));
+    EXPECT_EQ(0, e1);
+    EXPECT_EQ(1, e2);
+}
+
+TEST(Polyline, vertex_on_other_edge_is_not_simple) {
+    Polyline line({ { 0, 0 }, { 2, 0 }, { 2, 1 }, { 1, 1 }, { 1, 0 } });
+
+    EXPECT_FALSE(line.isSimple());
+}
+
+TEST(Polyline, sweep_matches_naive_on_random_polylines) {
+    for (int seed = 0; seed < 2000; ++seed) {
+        srand(seed);
+        int n = 3 + rand() % 40;
+        std::vector<point> v(n);
+        for (int i = 0; i < n; ++i) {
+            // Звёздный многоугольник, у части вершин - целые координаты для вырожденных случаев
+            double t = 2 * M_PI * i / n;
+            double r = 0.5 + 0.5 * rand() / RAND_MAX;
+            v[i] = { r * cos(t), r * sin(t) };
+            if (seed % 3 == 0) v[i] = { std::round(v[i].x * 10), std::round(v[i].y * 10) };
+        }
+        if (seed % 3 == 1) v[rand() % n] = { 0.1 * rand() / RAND_MAX, 0.0 };
+
+        bool closed = seed % 2;
+        int e1, e2, n1, n2;
+        EXPECT_EQ(Polyline::findSelfIntersectionNaive(v.data(), n, closed, n1, n2),
+            Polyline::findSelfIntersection(v.data(), n, closed, e1, e2)) << "seed " << seed;
+    }
+}